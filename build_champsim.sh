@@ -73,9 +73,6 @@ fi
 # Check for multi-core
 if [ "$NUM_CORE" -gt "1" ]; then
     echo "Building multi-core ChampSim..."
-    sed -i.bak 's/\<NUM_CPUS 1\>/NUM_CPUS '${NUM_CORE}'/g' inc/champsim.h
-#	sed -i.bak 's/\<DRAM_CHANNELS 1\>/DRAM_CHANNELS 2/g' inc/champsim.h
-#	sed -i.bak 's/\<DRAM_CHANNELS_LOG2 0\>/DRAM_CHANNELS_LOG2 1/g' inc/champsim.h
 else
     if [ "$NUM_CORE" -lt "1" ]; then
         echo "Number of core: $NUM_CORE must be greater or equal than 1"
@@ -86,23 +83,17 @@ else
 fi
 echo
 
-# Change prefetchers and replacement policy
-cp branch/${BRANCH}.bpred branch/branch_predictor.cc
-cp prefetcher/${L1I_PREFETCHER}.l1i_pref prefetcher/l1i_prefetcher.cc
-cp prefetcher/${L1D_PREFETCHER}.l1d_pref prefetcher/l1d_prefetcher.cc
-cp prefetcher/${L2C_PREFETCHER}.l2c_pref prefetcher/l2c_prefetcher.cc
-cp prefetcher/${LLC_PREFETCHER}.llc_pref prefetcher/llc_prefetcher.cc
-cp replacement/${LLC_REPLACEMENT}.llc_repl replacement/llc_replacement.cc
-
-# Build
+# Build, every module is built in and the selected ones become the defaults of the binary
+# the core count is passed to make, which keeps the objects of every core count in obj/<N>core
+BINARY_NAME="${BRANCH}-${L1I_PREFETCHER}-${L1D_PREFETCHER}-${L2C_PREFETCHER}-${LLC_PREFETCHER}-${LLC_REPLACEMENT}-${NUM_CORE}core"
 mkdir -p bin
-rm -f bin/champsim
-make clean
-make
+rm -f bin/${BINARY_NAME}
+make num_cpus=${NUM_CORE} app=${BINARY_NAME} branch_predictor=${BRANCH} l1i_prefetcher=${L1I_PREFETCHER} l1d_prefetcher=${L1D_PREFETCHER} \
+     l2c_prefetcher=${L2C_PREFETCHER} llc_prefetcher=${LLC_PREFETCHER} llc_replacement=${LLC_REPLACEMENT}
 
 # Sanity check
 echo ""
-if [ ! -f bin/champsim ]; then
+if [ ! -f bin/${BINARY_NAME} ]; then
     echo "${BOLD}ChampSim build FAILED!"
     echo ""
     exit 1
@@ -116,20 +107,5 @@ echo "L2C Prefetcher: ${L2C_PREFETCHER}"
 echo "LLC Prefetcher: ${LLC_PREFETCHER}"
 echo "LLC Replacement: ${LLC_REPLACEMENT}"
 echo "Cores: ${NUM_CORE}"
-BINARY_NAME="${BRANCH}-${L1I_PREFETCHER}-${L1D_PREFETCHER}-${L2C_PREFETCHER}-${LLC_PREFETCHER}-${LLC_REPLACEMENT}-${NUM_CORE}core"
 echo "Binary: bin/${BINARY_NAME}"
 echo ""
-mv bin/champsim bin/${BINARY_NAME}
-
-
-# Restore to the default configuration
-sed -i.bak 's/\<NUM_CPUS '${NUM_CORE}'\>/NUM_CPUS 1/g' inc/champsim.h
-#sed -i.bak 's/\<DRAM_CHANNELS 2\>/DRAM_CHANNELS 1/g' inc/champsim.h
-#sed -i.bak 's/\<DRAM_CHANNELS_LOG2 1\>/DRAM_CHANNELS_LOG2 0/g' inc/champsim.h
-
-cp branch/bimodal.bpred branch/branch_predictor.cc
-cp prefetcher/no.l1i_pref prefetcher/l1i_prefetcher.cc
-cp prefetcher/no.l1d_pref prefetcher/l1d_prefetcher.cc
-cp prefetcher/no.l2c_pref prefetcher/l2c_prefetcher.cc
-cp prefetcher/no.llc_pref prefetcher/llc_prefetcher.cc
-cp replacement/lru.llc_repl replacement/llc_replacement.cc
@@ -1,27 +1,44 @@
+// converts CVP-1 traces into ChampSim traces
+//
+// the conversion runs as a pipeline: one thread decompresses the CVP trace in-process, one parses and converts the records,
+// and one compresses the ChampSim trace (xz output uses the multi-threaded xz encoder).
+// given a directory, every trace in it is converted, -j of them at a time.
+//
+// build: g++ -O3 -std=c++11 -pthread cvp2champsim.cc -o cvp_tracer -lz -llzma
+
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <cstdint>
 #include <map>
-
-// defines for the paths for the various decompression programs and Apple/Linux differences
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <lzma.h>
+
+// Apple/Linux differences
 
 #ifdef __APPLE__
-#define XZ_PATH		"/opt/local/bin/xz"
-#define GZIP_PATH	"/usr/bin/gzip"
-#define CAT_PATH	"/bin/cat"
 #define UINT64		uint64_t
 #else
-#define XZ_PATH		"/usr/bin/xz"
-#define GZIP_PATH	"/bin/gzip"
-#define CAT_PATH	"/bin/cat"
 #define UINT64		unsigned long long int
 #endif
 
-using namespace std;
+// pipeline tuning
 
-bool verbose = false;
+#define PIPELINE_BLOCK_SIZE	(1<<22)	// bytes passed between stages at a time
+#define PIPELINE_DEPTH		8	// blocks in flight between two stages
+#define INPUT_BUFFER_SIZE	(1<<20)	// compressed bytes read from a file at a time
+
+using namespace std;
 
 // ChampSim trace format
 #define NUM_INSTR_DESTINATIONS 2
@@ -91,8 +108,6 @@ const char *branch_names[] = {
 "OPTYPE_MAX",
 };
 
-long long int counts[OPTYPE_MAX];
-
 // one record from the CVP-1 trace file format
 
 struct trace {
@@ -112,96 +127,176 @@ struct trace {
 
 	InstClass	type; // instruction type
 
-	// read a single record from the trace file, return true on success, false on EOF
+	// read a single record from the trace stream, return true on success, false on EOF
 
-	bool read (FILE *f) {
+	bool read (class block_reader *f);
+};
 
-		// initialize
+// bounded queue of byte blocks between two pipeline stages
 
-		PC = 0;
-		EA = 0;
-		target = 0;
-		access_size = 0;
-		taken = 0;
-		type = undefInstClass;
+class block_queue {
+public:
+	block_queue () : closed (false) { }
 
-		// get the PC
+	// hand a block to the next stage, waits while the next stage is behind
+	void push (vector<uint8_t> &block) {
+		unique_lock<mutex> guard (lock);
+		not_full.wait (guard, [this] { return blocks.size() < PIPELINE_DEPTH; });
+		blocks.push_back (vector<uint8_t>());
+		blocks.back().swap (block);
+		not_empty.notify_one ();
+	}
 
-		int n;
-		n = fread (&PC, 8, 1, f);
-		if (!n) return false;
-		if (feof (f)) return false;
-		assert (n == 1);
+	// take the next block, returns false once the previous stage is done and every block was taken
+	bool pop (vector<uint8_t> &block) {
+		unique_lock<mutex> guard (lock);
+		not_empty.wait (guard, [this] { return blocks.size() || closed; });
+		if (blocks.empty()) return false;
+		block.swap (blocks.front());
+		blocks.pop_front ();
+		not_full.notify_one ();
+		return true;
+	}
 
-		// get the instruction type
+	// no more blocks will be pushed
+	void close (void) {
+		lock_guard<mutex> guard (lock);
+		closed = true;
+		not_empty.notify_all ();
+	}
 
-		assert (fread (&type, 1, 1, f) == 1);
+private:
+	mutex lock;
+	condition_variable not_empty, not_full;
+	deque<vector<uint8_t> > blocks;
+	bool closed;
+};
 
-		// base on the type, read in different stuff
+// reads the byte stream coming out of a block_queue
 
-		switch (type) {
-		case loadInstClass:
-		case storeInstClass:
-			// load or store? get the effective address and access size
+class block_reader {
+public:
+	block_reader (block_queue *v1) : in (v1), pos (0) { }
 
-			assert (fread (&EA, 8, 1, f) == 1);
-			assert (fread (&access_size, 1, 1, f) == 1);
-			break;
-		case condBranchInstClass:
-		case uncondDirectBranchInstClass:
-		case uncondIndirectBranchInstClass:
+	// copy the next size bytes, returns false if the stream ends first
+	bool read (void *dest, size_t size) {
+		if (block.size() - pos >= size) {
+			memcpy (dest, &block[pos], size);
+			pos += size;
+			return true;
+		}
 
-			// branch? get "taken" and the target
+		// the bytes straddle two blocks
+		uint8_t *d = (uint8_t *) dest;
+		while (size) {
+			if (pos == block.size()) {
+				pos = 0;
+				block.clear ();
+				if (!in->pop (block)) return false;
+				continue;
+			}
+			size_t n = block.size() - pos;
+			if (n > size) n = size;
+			memcpy (d, &block[pos], n);
+			pos += n;
+			d += n;
+			size -= n;
+		}
+		return true;
+	}
 
-			assert (fread (&taken, 1, 1, f) == 1);
-			if (taken) {
-				assert (fread (&target, 8, 1, f) == 1);
-			} else {
-				// if not taken, default target is fallthru, i.e. PC+4
-				target = PC + 4;
+	// throw away the rest of the stream so that the previous stage can finish
+	void drain (void) {
+		while (in->pop (block)) ;
+		block.clear ();
+		pos = 0;
+	}
 
-				// this had better not be an unconditional branch (frickin ARM with its predicated branches)
+private:
+	block_queue *in;
+	vector<uint8_t> block;
+	size_t pos;
+};
 
-				assert (type != uncondDirectBranchInstClass);
-				assert (type != uncondIndirectBranchInstClass);
-			}
-			break;
-		default: ;
-		}
+bool trace::read (block_reader *f) {
 
-		// get the number of input registers and their names
+	// initialize
 
-		assert (fread (&num_input_regs, 1, 1, f) == 1);
-		for (int i=0; i<num_input_regs; i++) {
-			assert (fread (&input_reg_names[i], 1, 1, f) == 1);
-		}
+	PC = 0;
+	EA = 0;
+	target = 0;
+	access_size = 0;
+	taken = 0;
+	type = undefInstClass;
 
-		// get the number of output registers and their names
+	// get the PC
 
-		assert (fread (&num_output_regs, 1, 1, f) == 1);
-		for (int i=0; i<num_output_regs; i++) {
-			assert (fread (&output_reg_names[i], 1, 1, f) == 1);
-		}
+	if (!f->read (&PC, 8)) return false;
+
+	// get the instruction type
+
+	assert (f->read (&type, 1));
+
+	// base on the type, read in different stuff
 
-		// read the output registers
-
-		memset (output_reg_values, 0, sizeof (output_reg_values));
-		for (int i=0; i<num_output_regs; i++) {
-			if (output_reg_names[i] <= 31 || output_reg_names[i] == 64) {
-				// scalars or flags?
-				assert (fread (&output_reg_values[i][0], 8, 1, f) == 1);
-			} else if (output_reg_names[i] >= 32 && output_reg_names[i] < 64) {
-				// SIMD values?
-				assert (fread (&output_reg_values[i][0], 16, 1, f) == 1);
-			} else 
-				assert (0);
+	switch (type) {
+	case loadInstClass:
+	case storeInstClass:
+		// load or store? get the effective address and access size
+
+		assert (f->read (&EA, 8));
+		assert (f->read (&access_size, 1));
+		break;
+	case condBranchInstClass:
+	case uncondDirectBranchInstClass:
+	case uncondIndirectBranchInstClass:
+
+		// branch? get "taken" and the target
+
+		assert (f->read (&taken, 1));
+		if (taken) {
+			assert (f->read (&target, 8));
+		} else {
+			// if not taken, default target is fallthru, i.e. PC+4
+			target = PC + 4;
+
+			// this had better not be an unconditional branch (frickin ARM with its predicated branches)
+
+			assert (type != uncondDirectBranchInstClass);
+			assert (type != uncondIndirectBranchInstClass);
 		}
+		break;
+	default: ;
+	}
 
-		// success!
+	// get the number of input registers and their names
 
-		return true;
+	assert (f->read (&num_input_regs, 1));
+	assert (f->read (input_reg_names, num_input_regs));
+
+	// get the number of output registers and their names
+
+	assert (f->read (&num_output_regs, 1));
+	assert (f->read (output_reg_names, num_output_regs));
+
+	// read the output registers, only the slots that were written are cleared
+
+	for (int i=0; i<num_output_regs; i++) {
+		output_reg_values[i][1] = 0;
+		if (output_reg_names[i] <= 31 || output_reg_names[i] == 64) {
+			// scalars or flags?
+			assert (f->read (&output_reg_values[i][0], 8));
+		} else if (output_reg_names[i] >= 32 && output_reg_names[i] < 64) {
+			// SIMD values?
+			assert (f->read (&output_reg_values[i][0], 16));
+		} else 
+			assert (0);
 	}
-};
+
+	// success!
+
+	return true;
+}
 
 // is this a branch type?
 
@@ -211,115 +306,269 @@ bool is_branch (InstClass t) {
 		|| t == condBranchInstClass);
 }
 
-map<UINT64,bool> code_pages, data_pages;
-map<UINT64,UINT64> remapped_pages;
-UINT64 bump_page = 0x1000;
-
-// this string will contain the trace file name, or "-" if we want to read from standard input
-
-char tracefilename[1000];
-
 #define REG_SP		6
 #define REG_IP		26
 #define REG_FLAGS	25
 #define REG_AX		56
 
-FILE *open_trace_file (void) {
-	FILE *f = NULL;
+// file formats, told apart by their magic number (input) or extension (output)
 
-	// read from standard input?
+typedef enum {
+	RAW_FORMAT,
+	GZ_FORMAT,
+	XZ_FORMAT
+} FileFormat;
+
+FileFormat input_format (const char *filename) {
+	// standard input is read as is
+	if (!strcmp (filename, "-")) return RAW_FORMAT;
+
+	FILE *f = fopen (filename, "rb");
+	if (!f) {
+		perror (filename);
+		exit (1);
+	}
 
-	if (!strcmp (tracefilename, "-")) {
-		fprintf (stderr, "reading from standard input\n");
-		fflush (stderr);
-		f = stdin;
-	} else {
+	// read six bytes from the beginning of the file
 
-		// see what kind of file this is by reading the magic number
+	unsigned char s[6];
+	int n = fread (s, 1, 6, f);
+	fclose (f);
+	assert (n == 6);
 
-		f = fopen (tracefilename, "r");
-		if (!f) {
-			perror (tracefilename);
-			exit (1);
-		}
+	if (s[0] == 0xfd && s[1] == '7' && s[2] == 'z' && s[3] == 'X' && s[4] == 'Z' && s[5] == 0) return XZ_FORMAT;
+	if (s[0] == 0x1f && s[1] == 0x8b) return GZ_FORMAT;
 
-		// read six bytes from the beginning of the file
-
-		unsigned char s[6];
-		int n = fread (s, 1, 6, f);
-		fclose (f);
-		assert (n == 6);
+	// no magic number? maybe it's uncompressed
+	return RAW_FORMAT;
+}
 
-		// is this the magic number for XZ compression?
+FileFormat output_format (const string &filename) {
+	size_t dot = filename.find_last_of ('.');
+	string extension = (dot == string::npos) ? "" : filename.substr (dot + 1);
+	if (extension == "xz") return XZ_FORMAT;
+	if (extension == "gz") return GZ_FORMAT;
+	return RAW_FORMAT;
+}
 
-		if (s[0] == 0xfd && s[1] == '7' && s[2] == 'z' && s[3] == 'X' && s[4] == 'Z' && s[5] == 0) {
+// decompression stage: turns a (compressed) file into a stream of blocks
 
-			// it is an XZ file or doing a good impression of one
+void decompress_stage (const char *filename, bool progress, block_queue *out) {
+	FileFormat format = input_format (filename);
+	FILE *f = strcmp (filename, "-") ? fopen (filename, "rb") : stdin;
+	if (!f) {
+		perror (filename);
+		exit (1);
+	}
 
-			char cmd[1000];
-			fprintf (stderr, "opening xz file \"%s\"\n", tracefilename);
-			fflush (stderr);
+	if (progress) {
+		if (f == stdin) fprintf (stderr, "reading from standard input\n");
+		else if (format == XZ_FORMAT) fprintf (stderr, "opening xz file \"%s\"\n", filename);
+		else if (format == GZ_FORMAT) fprintf (stderr, "opening gz file \"%s\"\n", filename);
+		else fprintf (stderr, "opening file \"%s\"\n", filename);
+		fflush (stderr);
+	}
 
-			// start up an xz decompression and open a pipe to our standard input
+	vector<uint8_t> input (INPUT_BUFFER_SIZE), block;
+	z_stream zs;
+	lzma_stream xs = LZMA_STREAM_INIT;
+	if (format == GZ_FORMAT) {
+		memset (&zs, 0, sizeof (zs));
+		assert (inflateInit2 (&zs, 15+32) == Z_OK);
+	} else if (format == XZ_FORMAT) {
+		assert (lzma_stream_decoder (&xs, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK);
+	}
 
-			sprintf (cmd, "%s -dc %s", XZ_PATH, tracefilename);
-			f = popen (cmd, "r");
-			if (!f) {
-				perror (cmd);
-				return NULL;
+	bool input_done = false, output_done = false;
+	size_t input_size = 0;
+	while (!output_done) {
+		block.resize (PIPELINE_BLOCK_SIZE);
+		size_t produced = 0;
+
+		if (format == RAW_FORMAT) {
+			produced = fread (&block[0], 1, PIPELINE_BLOCK_SIZE, f);
+			output_done = (produced == 0);
+		} else if (format == GZ_FORMAT) {
+			zs.next_out = &block[0];
+			zs.avail_out = PIPELINE_BLOCK_SIZE;
+			while (zs.avail_out) {
+				if (zs.avail_in == 0) {
+					input_size = fread (&input[0], 1, INPUT_BUFFER_SIZE, f);
+					zs.next_in = &input[0];
+					zs.avail_in = input_size;
+					if (input_size == 0) {
+						output_done = true;
+						break;
+					}
+				}
+				int ret = inflate (&zs, Z_NO_FLUSH);
+				// concatenated gzip members are decoded back to back, like gzip -dc does
+				if (ret == Z_STREAM_END) inflateReset (&zs);
+				else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+					fprintf (stderr, "%s: gzip decode error %d\n", filename, ret);
+					exit (1);
+				}
+			}
+			produced = PIPELINE_BLOCK_SIZE - zs.avail_out;
+		} else {
+			xs.next_out = &block[0];
+			xs.avail_out = PIPELINE_BLOCK_SIZE;
+			while (xs.avail_out) {
+				if (xs.avail_in == 0 && !input_done) {
+					input_size = fread (&input[0], 1, INPUT_BUFFER_SIZE, f);
+					xs.next_in = &input[0];
+					xs.avail_in = input_size;
+					input_done = (input_size == 0);
+				}
+				lzma_ret ret = lzma_code (&xs, input_done ? LZMA_FINISH : LZMA_RUN);
+				if (ret == LZMA_STREAM_END) {
+					output_done = true;
+					break;
+				}
+				if (ret != LZMA_OK) {
+					fprintf (stderr, "%s: xz decode error %d\n", filename, ret);
+					exit (1);
+				}
 			}
-		} 
-		// check for the magic number for GZIP compression
+			produced = PIPELINE_BLOCK_SIZE - xs.avail_out;
+		}
 
-		else if (s[0] == 0x1f && s[1] == 0x8b) {
-			// it is a GZ file
-			char cmd[1000];
-			fprintf (stderr, "opening gz file \"%s\"\n", tracefilename);
-			fflush (stderr);
+		if (produced) {
+			block.resize (produced);
+			out->push (block);
+		}
+	}
 
-			// open a pipe to a gzip decompression process
+	if (format == GZ_FORMAT) inflateEnd (&zs);
+	else if (format == XZ_FORMAT) lzma_end (&xs);
+	if (f != stdin) fclose (f);
+	out->close ();
+}
 
-			sprintf (cmd, "%s -dc %s", GZIP_PATH, tracefilename);
-			f = popen (cmd, "r");
-			if (!f) {
-				perror (cmd);
-				return NULL;
-			}
-		} else {
-			// no magic number? maybe it's uncompressed?
-			char cmd[1000];
-			fprintf (stderr, "opening file \"%s\"\n", tracefilename);
-			fflush (stderr);
+// compression stage: writes the stream of blocks to the output, compressed according to its extension
+
+void compress_stage (FILE *f, FileFormat format, int threads, block_queue *in) {
+	vector<uint8_t> block, output (PIPELINE_BLOCK_SIZE);
+	z_stream zs;
+	lzma_stream xs = LZMA_STREAM_INIT;
+	if (format == GZ_FORMAT) {
+		memset (&zs, 0, sizeof (zs));
+		assert (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+	} else if (format == XZ_FORMAT) {
+		lzma_mt mt;
+		memset (&mt, 0, sizeof (mt));
+		mt.threads = threads;
+		mt.preset = LZMA_PRESET_DEFAULT;
+		mt.check = LZMA_CHECK_CRC64;
+		assert (lzma_stream_encoder_mt (&xs, &mt) == LZMA_OK);
+	}
 
-			// use Unix cat to open and read this file. we could just fopen the file
-			// but then we're pclosing it later so that could get weird
+	bool done = false;
+	while (!done) {
+		done = !in->pop (block);
+
+		if (format == RAW_FORMAT) {
+			if (!done) fwrite (&block[0], 1, block.size(), f);
+			continue;
+		}
 
-			sprintf (cmd, "%s %s", CAT_PATH, tracefilename);
-			f = popen (cmd, "r");
-			if (!f) {
-				perror (cmd);
-				return NULL;
+		// compress the block, or flush the compressor at the end of the stream
+		bool finished = false;
+		if (format == GZ_FORMAT) {
+			zs.next_in = done ? NULL : &block[0];
+			zs.avail_in = done ? 0 : block.size();
+			while (!finished) {
+				zs.next_out = &output[0];
+				zs.avail_out = output.size();
+				int ret = deflate (&zs, done ? Z_FINISH : Z_NO_FLUSH);
+				assert (ret != Z_STREAM_ERROR);
+				fwrite (&output[0], 1, output.size() - zs.avail_out, f);
+				finished = done ? (ret == Z_STREAM_END) : (zs.avail_in == 0 && zs.avail_out != 0);
+			}
+		} else {
+			xs.next_in = done ? NULL : &block[0];
+			xs.avail_in = done ? 0 : block.size();
+			while (!finished) {
+				xs.next_out = &output[0];
+				xs.avail_out = output.size();
+				lzma_ret ret = lzma_code (&xs, done ? LZMA_FINISH : LZMA_RUN);
+				assert (ret == LZMA_OK || ret == LZMA_STREAM_END);
+				fwrite (&output[0], 1, output.size() - xs.avail_out, f);
+				finished = done ? (ret == LZMA_STREAM_END) : (xs.avail_in == 0 && xs.avail_out != 0);
 			}
 		}
 	}
-	return f;
+
+	if (format == GZ_FORMAT) deflateEnd (&zs);
+	else if (format == XZ_FORMAT) lzma_end (&xs);
+	fflush (f);
 }
 
-void preprocess_file (void) {
+// converts one CVP trace, everything that depends on the trace lives here so that several traces can be converted at once
+
+class cvp_converter {
+public:
+	const char *tracefilename;	// the trace file name, or "-" to read from standard input
+	bool verbose, progress;
+
+	cvp_converter (const char *v1, bool v2, bool v3) : tracefilename (v1), verbose (v2), progress (v3) {
+		bump_page = 0x1000;
+		num_allocs = 0;
+		memset (counts, 0, sizeof (counts));
+	}
+
+	// first pass: find code and data pages
+	void preprocess_file (void);
+
+	// second pass: convert the trace into blocks of ChampSim records, returns the number of records read
+	long long int convert (block_queue *out);
+
+	void print_counts (long long int n);
+
+private:
+	map<UINT64,bool> code_pages, data_pages;
+	map<UINT64,UINT64> remapped_pages;
+	UINT64 bump_page;
+	int num_allocs;
+	long long int counts[OPTYPE_MAX];
+
+	vector<uint8_t> out_block;
+	block_queue *out_queue;
+
+	UINT64 transform (UINT64 a);
+
+	void emit (trace_instr_format &ct) {
+		size_t pos = out_block.size();
+		out_block.resize (pos + sizeof (ct));
+		memcpy (&out_block[pos], &ct, sizeof (ct));
+		if (out_block.size() + sizeof (ct) > PIPELINE_BLOCK_SIZE) {
+			out_queue->push (out_block);
+			out_block.clear ();
+			out_block.reserve (PIPELINE_BLOCK_SIZE);
+		}
+	}
+};
+
+void cvp_converter::preprocess_file (void) {
 	trace t;
-	fprintf (stderr, "preprocessing to find code and data pages...\n");
-	fflush (stderr);
-	FILE *f = open_trace_file ();
-	if (!f) return;
+	if (progress) {
+		fprintf (stderr, "preprocessing to find code and data pages...\n");
+		fflush (stderr);
+	}
+
+	block_queue in;
+	thread decompressor (decompress_stage, tracefilename, progress, &in);
+	block_reader f (&in);
+
 	int count = 0;
 	for (;;) {
-		bool good = t.read (f);
+		bool good = t.read (&f);
 		if (!good) break;
 		code_pages[t.PC>>12] = true;
 		if (t.type == loadInstClass || t.type == storeInstClass)
 			data_pages[t.EA>>12] = true;
 		count++;
-		if (count % 10000000 == 0) {
+		if (progress && count % 10000000 == 0) {
 			fprintf (stderr, "."); 
 			fflush (stderr);
 			if (count % 600000000 == 0) {
@@ -328,22 +577,27 @@ void preprocess_file (void) {
 			}
 		}
 	}
-	pclose (f);
-	fprintf (stderr, "%ld code pages, %ld data pages\n", code_pages.size(), data_pages.size());
-	fflush (stderr);
+	f.drain ();
+	decompressor.join ();
+
+	if (progress) {
+		fprintf (stderr, "%ld code pages, %ld data pages\n", code_pages.size(), data_pages.size());
+		fflush (stderr);
+	}
 }
 
 // take an address representing data and make sure it doesn't overlap with code
 
-UINT64 transform (UINT64 a) {
-	static int num_allocs = 0;
+UINT64 cvp_converter::transform (UINT64 a) {
 	UINT64 page = a >> 12;
 	UINT64 new_page = page;
 	if (code_pages.find (page) != code_pages.end()) {
 		new_page = remapped_pages[page];
 		if (new_page == 0) {
 			num_allocs++;
-			fprintf (stderr, "[%d]", num_allocs); fflush (stderr);
+			if (progress) {
+				fprintf (stderr, "[%d]", num_allocs); fflush (stderr);
+			}
 			// allocate a new page
 			new_page = bump_page;
 			for (;;) {
@@ -360,34 +614,19 @@ UINT64 transform (UINT64 a) {
 	return a;
 }
 
-int main (int argc, char **argv) {
+long long int cvp_converter::convert (block_queue *out) {
 	trace t;
 
-	// for fun we will keep a register file up to date
-
-	UINT64 registers[256][2];
-	memset (registers, 0, sizeof (registers));
+	out_queue = out;
+	out_block.reserve (PIPELINE_BLOCK_SIZE);
 
-	// defaults to reading from standard input
-
-	strcpy (tracefilename, "-");
-
-	for (int i=1; i<argc; i++) {
-		if (!strcmp (argv[i], "-v")) verbose = true; else strcpy (tracefilename, argv[i]);
-	}
-
-	preprocess_file ();
-
-	// open the trace file
-
-	FILE *f = open_trace_file ();
-
-	if (!f) return 1;
+	block_queue in;
+	thread decompressor (decompress_stage, tracefilename, progress, &in);
+	block_reader f (&in);
 
 	// number of records read so far
 	long long int n = 0;
-	trace oldt;
-	oldt.PC = 0;
+	UINT64 old_pc = 0;
 
 	// loop getting records until we're done
 
@@ -399,19 +638,19 @@ int main (int argc, char **argv) {
 
 		// print something to entertain the user while they wait
 
-		if (n % 1000000 == 0) {
+		if (progress && n % 1000000 == 0) {
 			fprintf (stderr, "%lld instructions\n", n);
 			fflush (stderr);
 		}
 
-		// read a record from the trace file
+		// read a record from the trace stream
 
-		bool good = t.read (f);
-		if (t.PC == oldt.PC) {
+		bool good = t.read (&f);
+		if (t.PC == old_pc) {
 			fprintf (stderr, "hmm, that's weird\n");
 		}
 
-		oldt = t;
+		old_pc = t.PC;
 
 		// are we done? then stop.
 
@@ -522,7 +761,7 @@ int main (int argc, char **argv) {
 				break;
 			default: assert (0);
 			}
-			fwrite (&ct, sizeof (ct), 1, stdout); // write a branch trace
+			emit (ct); // write a branch trace
 		} else {
 			memset (ct.destination_registers, 0, sizeof (ct.destination_registers));
 			memset (ct.source_registers, 0, sizeof (ct.source_registers));
@@ -567,17 +806,10 @@ int main (int argc, char **argv) {
 				case undefInstClass: 
 					assert (0);
 				}
-				fwrite (&ct, sizeof (ct), 1, stdout); // write a non-branch trace
+				emit (ct); // write a non-branch trace
 			}
 		}
 		
-		// for fun, update the register values
-
-		for (int i=0; i<t.num_output_regs; i++) {
-			int x = t.output_reg_names[i];
-			registers[x][0] = t.output_reg_values[x][0];
-			registers[x][1] = t.output_reg_values[x][1];
-		}
 		if (verbose) {
 			static long long int n = 0;
 			fprintf (stderr, "%lld %llx ", ++n, t.PC);
@@ -607,15 +839,120 @@ int main (int argc, char **argv) {
 			fprintf (stderr, "\n");
 		}
 	}
+	f.drain ();
+	decompressor.join ();
+
+	if (out_block.size()) out_queue->push (out_block);
+	out_queue->close ();
+
+	return n;
+}
+
+void cvp_converter::print_counts (long long int n) {
 	fprintf (stderr, "converted %lld instructions\n", n);
 	OpType lim = OPTYPE_MAX;
 	for (int i=2; i<(int)lim; i++) {
 		if (counts[i])
 			fprintf (stderr, "%s %lld %f%%\n", branch_names[i], counts[i], 100 * counts[i] / (double) n);
 	}
+}
+
+// convert one trace into output ("-" for standard output), compressed according to the output extension
+
+long long int convert_trace (const char *input, const string &output, bool verbose, bool progress, int threads) {
+	FILE *f = (output == "-") ? stdout : fopen (output.c_str(), "wb");
+	if (!f) {
+		perror (output.c_str());
+		exit (1);
+	}
 
-	// close the pipe, if any
+	cvp_converter converter (input, verbose, progress);
+	converter.preprocess_file ();
+
+	block_queue out;
+	thread compressor (compress_stage, f, (output == "-") ? RAW_FORMAT : output_format (output), threads, &out);
+	long long int n = converter.convert (&out);
+	compressor.join ();
+
+	if (f != stdout) fclose (f);
+	if (progress) converter.print_counts (n);
+
+	return n;
+}
+
+int main (int argc, char **argv) {
+	// defaults to reading from standard input and writing an uncompressed trace to standard output
+
+	const char *input = "-";
+	string output = "-";
+	bool verbose = false;
+	int threads = thread::hardware_concurrency(), jobs = 1;
+	if (threads < 1) threads = 1;
+
+	for (int i=1; i<argc; i++) {
+		if (!strcmp (argv[i], "-v")) verbose = true;
+		else if (!strcmp (argv[i], "-o") && i+1 < argc) output = argv[++i];
+		else if (!strcmp (argv[i], "-t") && i+1 < argc) threads = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-j") && i+1 < argc) jobs = atoi (argv[++i]);
+		else input = argv[i];
+	}
+	if (threads < 1) threads = 1;
+	if (jobs < 1) jobs = 1;
+
+	struct stat input_stat;
+	if (strcmp (input, "-") && stat (input, &input_stat) == 0 && S_ISDIR (input_stat.st_mode)) {
+
+		// convert every trace of the directory into OUTPUT_DIRECTORY/NAME.champsimtrace.xz
+
+		if (output == "-") {
+			fprintf (stderr, "usage: %s [-j JOBS] [-t THREADS] -o OUTPUT_DIRECTORY INPUT_DIRECTORY\n", argv[0]);
+			return 1;
+		}
+		mkdir (output.c_str(), 0755);
+
+		vector<string> names;
+		DIR *dir = opendir (input);
+		if (!dir) {
+			perror (input);
+			return 1;
+		}
+		for (struct dirent *entry = readdir (dir); entry; entry = readdir (dir)) {
+			string path = string (input) + "/" + entry->d_name;
+			if (stat (path.c_str(), &input_stat) == 0 && S_ISREG (input_stat.st_mode))
+				names.push_back (entry->d_name);
+		}
+		closedir (dir);
+
+		// the xz encoder threads are split between the traces converted at once
+		int threads_per_job = threads / jobs;
+		if (threads_per_job < 1) threads_per_job = 1;
+
+		atomic<size_t> next_name (0);
+		mutex log_lock;
+		vector<thread> workers;
+		for (int j=0; j<jobs; j++) {
+			workers.push_back (thread ([&] {
+				for (size_t k = next_name++; k < names.size(); k = next_name++) {
+					string name = names[k], base = name;
+					size_t dot = base.find_last_of ('.');
+					if (dot != string::npos && (base.substr (dot) == ".gz" || base.substr (dot) == ".xz"))
+						base = base.substr (0, dot);
+
+					string in_path = string (input) + "/" + name,
+					       out_path = output + "/" + base + ".champsimtrace.xz";
+					long long int n = convert_trace (in_path.c_str(), out_path, false, false, threads_per_job);
+
+					lock_guard<mutex> guard (log_lock);
+					fprintf (stderr, "%s -> %s: converted %lld instructions\n", in_path.c_str(), out_path.c_str(), n);
+					fflush (stderr);
+				}
+			}));
+		}
+		for (size_t j=0; j<workers.size(); j++) workers[j].join ();
+
+		return 0;
+	}
 
-	if (f != stdin) pclose (f);
+	convert_trace (input, output, verbose, true, threads);
 	return 0;
 }
@@ -169,6 +169,30 @@ class PACKET {
     };
 };
 
+// slots of a queue whose entries come and go in any order (LQ, MSHR)
+// free slots are handed out lowest first, as the scan for an empty entry did, and each slot is also found by its address
+class QUEUE_SLOTS {
+  public:
+    const uint32_t SIZE;
+
+    QUEUE_SLOTS(uint32_t v1);
+    ~QUEUE_SLOTS();
+
+    // SIZE when no slot is free
+    uint32_t allocate(uint64_t address);
+    void release(uint32_t slot);
+    // the lowest slot holding address, SIZE when none does
+    uint32_t find(uint64_t address);
+    // the lowest slot in use from slot on, SIZE when none is
+    uint32_t next_used(uint32_t slot);
+
+  private:
+    uint64_t *free_bits, *slot_address;
+    uint32_t *bucket, *next, num_words, bucket_bits;
+
+    uint32_t hash(uint64_t address) { return (address * 0x9E3779B97F4A7C15ULL) >> (64 - bucket_bits); };
+};
+
 // packet queue
 class PACKET_QUEUE {
   public:
@@ -200,9 +224,12 @@ class PACKET_QUEUE {
              FULL;
 
     PACKET *entry, processed_packet[2*MAX_READ_PER_CYCLE];
+    QUEUE_SLOTS *slots; // only for the MSHR, filled in any order
 
     // constructor
     PACKET_QUEUE(string v1, uint32_t v2) : NAME(v1), SIZE(v2) {
+        slots = NULL;
+
         is_RQ = 0;
         is_WQ = 0;
         write_mode = 0;
@@ -232,6 +259,7 @@ class PACKET_QUEUE {
     };
 
     PACKET_QUEUE() {
+        slots = NULL;
         is_RQ = 0;
         is_WQ = 0;
 
@@ -262,6 +290,7 @@ class PACKET_QUEUE {
     // destructor
     ~PACKET_QUEUE() {
         delete[] entry;
+        delete slots;
     };
 
     // functions
@@ -375,6 +404,7 @@ class LOAD_STORE_QUEUE {
     uint32_t occupancy, head, tail;
 
     LSQ_ENTRY *entry;
+    QUEUE_SLOTS *slots; // only for the LQ, the SQ is filled in order
 
     // constructor
     LOAD_STORE_QUEUE(string v1, uint32_t v2) : NAME(v1), SIZE(v2) {
@@ -383,11 +413,13 @@ class LOAD_STORE_QUEUE {
         tail = 0;
 
         entry = new LSQ_ENTRY[SIZE];
+        slots = NULL;
     };
 
     // destructor
     ~LOAD_STORE_QUEUE() {
         delete[] entry;
+        delete slots;
     };
 };
 #endif
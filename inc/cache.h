@@ -2,6 +2,7 @@
 #define CACHE_H
 
 #include "memory_class.h"
+#include "module.h"
 
 // PAGE
 extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
@@ -15,74 +16,51 @@ extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
 #define IS_L2C  5
 #define IS_LLC  6
 
-// INSTRUCTION TLB
-#define ITLB_SET 16
-#define ITLB_WAY 4
-#define ITLB_RQ_SIZE 16
-#define ITLB_WQ_SIZE 16
-#define ITLB_PQ_SIZE 0
-#define ITLB_MSHR_SIZE 8
-#define ITLB_LATENCY 1
-
-// DATA TLB
-#define DTLB_SET 16
-#define DTLB_WAY 4
-#define DTLB_RQ_SIZE 16
-#define DTLB_WQ_SIZE 16
-#define DTLB_PQ_SIZE 0
-#define DTLB_MSHR_SIZE 8
-#define DTLB_LATENCY 1
-
-// SECOND LEVEL TLB
-#define STLB_SET 128
-#define STLB_WAY 12
-#define STLB_RQ_SIZE 32
-#define STLB_WQ_SIZE 32
-#define STLB_PQ_SIZE 0
-#define STLB_MSHR_SIZE 16
-#define STLB_LATENCY 8
-
-// L1 INSTRUCTION CACHE
-#define L1I_SET 64
-#define L1I_WAY 8
-#define L1I_RQ_SIZE 64
-#define L1I_WQ_SIZE 64 
-#define L1I_PQ_SIZE 32
-#define L1I_MSHR_SIZE 8
-#define L1I_LATENCY 4
-
-// L1 DATA CACHE
-#define L1D_SET 64
-#define L1D_WAY 12
-#define L1D_RQ_SIZE 64
-#define L1D_WQ_SIZE 64 
-#define L1D_PQ_SIZE 8
-#define L1D_MSHR_SIZE 16
-#define L1D_LATENCY 5 
-
-// L2 CACHE
-#define L2C_SET 1024
-#define L2C_WAY 8
-#define L2C_RQ_SIZE 32
-#define L2C_WQ_SIZE 32
-#define L2C_PQ_SIZE 16
-#define L2C_MSHR_SIZE 32
-#define L2C_LATENCY 10  // 4/5 (L1I or L1D) + 10 = 14/15 cycles
-
-// LAST LEVEL CACHE
-#define LLC_SET NUM_CPUS*2048
-#define LLC_WAY 16
-#define LLC_RQ_SIZE NUM_CPUS*L2C_MSHR_SIZE //48
-#define LLC_WQ_SIZE NUM_CPUS*L2C_MSHR_SIZE //48
-#define LLC_PQ_SIZE NUM_CPUS*32
-#define LLC_MSHR_SIZE NUM_CPUS*64
-#define LLC_LATENCY 20  // 4/5 (L1I or L1D) + 10 + 20 = 34/35 cycles
+// cache geometry and latency, set at runtime (config.h)
+extern uint32_t ITLB_SET, ITLB_WAY, ITLB_RQ_SIZE, ITLB_WQ_SIZE, ITLB_PQ_SIZE, ITLB_MSHR_SIZE, ITLB_LATENCY;
+extern uint32_t DTLB_SET, DTLB_WAY, DTLB_RQ_SIZE, DTLB_WQ_SIZE, DTLB_PQ_SIZE, DTLB_MSHR_SIZE, DTLB_LATENCY;
+extern uint32_t STLB_SET, STLB_WAY, STLB_RQ_SIZE, STLB_WQ_SIZE, STLB_PQ_SIZE, STLB_MSHR_SIZE, STLB_LATENCY;
+extern uint32_t L1I_SET, L1I_WAY, L1I_RQ_SIZE, L1I_WQ_SIZE, L1I_PQ_SIZE, L1I_MSHR_SIZE, L1I_LATENCY;
+extern uint32_t L1D_SET, L1D_WAY, L1D_RQ_SIZE, L1D_WQ_SIZE, L1D_PQ_SIZE, L1D_MSHR_SIZE, L1D_LATENCY;
+extern uint32_t L2C_SET, L2C_WAY, L2C_RQ_SIZE, L2C_WQ_SIZE, L2C_PQ_SIZE, L2C_MSHR_SIZE, L2C_LATENCY;
+extern uint32_t LLC_SET, LLC_WAY, LLC_RQ_SIZE, LLC_WQ_SIZE, LLC_PQ_SIZE, LLC_MSHR_SIZE, LLC_LATENCY;
+
+// per-set kernels of the tag lookup and the LRU update
+// the common associativities get their own instantiation with a constant trip count the compiler unrolls,
+// WAYS == 0 is the generic one for any associativity. CACHE::find_way() and CACHE::lru_update_set() switch on
+// the associativity and call them directly, so they are inlined into their callers.
+#define CACHE_KERNEL_WAYS(f) f(4) f(8) f(12) f(16)
+
+template <uint32_t WAYS>
+int find_way_kernel(const BLOCK *set_block, uint64_t tag, uint32_t num_way)
+{
+    const uint32_t ways = WAYS ? WAYS : num_way;
+    for (uint32_t way=0; way<ways; way++) {
+        if (set_block[way].valid && (set_block[way].tag == tag))
+            return way;
+    }
+
+    return -1;
+}
+
+template <uint32_t WAYS>
+void lru_update_kernel(BLOCK *set_block, uint32_t way, uint32_t num_way)
+{
+    const uint32_t ways = WAYS ? WAYS : num_way,
+                   lru = set_block[way].lru;
+    for (uint32_t i=0; i<ways; i++) {
+        if (set_block[i].lru < lru)
+            set_block[i].lru++;
+    }
+    set_block[way].lru = 0; // promote to the MRU position
+}
 
 class CACHE : public MEMORY {
   public:
     uint32_t cpu;
     const string NAME;
     const uint32_t NUM_SET, NUM_WAY, NUM_LINE, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE;
+    const uint64_t SET_MASK;
     uint32_t LATENCY;
     BLOCK **block;
     int fill_level;
@@ -114,10 +92,11 @@ class CACHE : public MEMORY {
     uint64_t total_miss_latency;
     
     // constructor
-    CACHE(string v1, uint32_t v2, int v3, uint32_t v4, uint32_t v5, uint32_t v6, uint32_t v7, uint32_t v8) 
-        : NAME(v1), NUM_SET(v2), NUM_WAY(v3), NUM_LINE(v4), WQ_SIZE(v5), RQ_SIZE(v6), PQ_SIZE(v7), MSHR_SIZE(v8) {
+    CACHE(string v1, uint32_t v2, uint32_t v3, uint32_t v4, uint32_t v5, uint32_t v6, uint32_t v7, uint32_t v8) 
+        : NAME(v1), NUM_SET(v2), NUM_WAY(v3), NUM_LINE(v4), WQ_SIZE(v5), RQ_SIZE(v6), PQ_SIZE(v7), MSHR_SIZE(v8), SET_MASK((1 << lg2(v2)) - 1) {
 
         LATENCY = 0;
+        MSHR.slots = new QUEUE_SLOTS(MSHR_SIZE);
 
         // cache block
         block = new BLOCK* [NUM_SET];
@@ -172,11 +151,15 @@ class CACHE : public MEMORY {
 
     void return_data(PACKET *packet),
          operate(),
-         increment_WQ_FULL(uint64_t address);
+         increment_WQ_FULL(uint64_t address),
+         functional_access(PACKET *packet),
+         functional_prefetcher_operate(PACKET *packet, uint8_t hit, uint8_t prefetch_hit);
 
     uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
              get_size(uint8_t queue_type, uint64_t address);
 
+    uint64_t next_operate_cycle();
+
     int  check_hit(PACKET *packet),
          invalidate_entry(uint64_t inval_addr),
          check_mshr(PACKET *packet),
@@ -208,7 +191,31 @@ class CACHE : public MEMORY {
          //prefetcher_final_stats(),
          l1d_prefetcher_final_stats(),
          l2c_prefetcher_final_stats(),
-         llc_prefetcher_final_stats();
+         llc_prefetcher_final_stats(),
+         l1d_prefetcher_checkpoint(CHECKPOINT &checkpoint),
+         l2c_prefetcher_checkpoint(CHECKPOINT &checkpoint),
+         llc_prefetcher_checkpoint(CHECKPOINT &checkpoint),
+         llc_replacement_checkpoint(CHECKPOINT &checkpoint),
+         checkpoint(CHECKPOINT &checkpoint);
+
+    int find_way(const BLOCK *set_block, uint64_t tag) {
+#define FIND_WAY_CASE(ways) case ways: return find_way_kernel<ways>(set_block, tag, ways);
+        switch (NUM_WAY) {
+            CACHE_KERNEL_WAYS(FIND_WAY_CASE)
+        }
+#undef FIND_WAY_CASE
+        return find_way_kernel<0>(set_block, tag, NUM_WAY);
+    };
+
+    void lru_update_set(BLOCK *set_block, uint32_t way) {
+#define LRU_UPDATE_CASE(ways) case ways: lru_update_kernel<ways>(set_block, way, ways); return;
+        switch (NUM_WAY) {
+            CACHE_KERNEL_WAYS(LRU_UPDATE_CASE)
+        }
+#undef LRU_UPDATE_CASE
+        lru_update_kernel<0>(set_block, way, NUM_WAY);
+    };
+
     void (*l1i_prefetcher_cache_operate)(uint32_t, uint64_t, uint8_t, uint8_t);
     void (*l1i_prefetcher_cache_fill)(uint32_t, uint64_t, uint32_t, uint32_t, uint8_t, uint64_t);
 
@@ -216,6 +223,11 @@ class CACHE : public MEMORY {
          llc_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in),
          l2c_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in),
          llc_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in);
+
+    L1D_PREFETCHERS(DECLARE_L1D_PREFETCHER)
+    L2C_PREFETCHERS(DECLARE_L2C_PREFETCHER)
+    LLC_PREFETCHERS(DECLARE_LLC_PREFETCHER)
+    LLC_REPLACEMENTS(DECLARE_LLC_REPLACEMENT)
     
     uint32_t get_set(uint64_t address),
              get_way(uint64_t address, uint32_t set),
@@ -33,9 +33,10 @@
 #endif
 
 // CPU
+#ifndef NUM_CPUS // set by the Makefile, make num_cpus=4
 #define NUM_CPUS 1
-#define CPU_FREQ 4000
-#define DRAM_IO_FREQ 3200
+#endif
+extern uint32_t CPU_FREQ, DRAM_IO_FREQ;
 #define PAGE_SIZE 4096
 #define LOG2_PAGE_SIZE 12
 
@@ -55,17 +56,15 @@
 #define FILL_DRAM 16
 
 // DRAM
-#define DRAM_CHANNELS 1      // default: assuming one DIMM per one channel 4GB * 1 => 4GB off-chip memory
-#define LOG2_DRAM_CHANNELS 0
-#define DRAM_RANKS 1         // 512MB * 8 ranks => 4GB per DIMM
-#define LOG2_DRAM_RANKS 0
-#define DRAM_BANKS 8         // 64MB * 8 banks => 512MB per rank
-#define LOG2_DRAM_BANKS 3
-#define DRAM_ROWS 65536      // 2KB * 32K rows => 64MB per bank
-#define LOG2_DRAM_ROWS 16
-#define DRAM_COLUMNS 128      // 64B * 32 column chunks (Assuming 1B DRAM cell * 8 chips * 8 transactions = 64B size of column chunks) => 2KB per row
-#define LOG2_DRAM_COLUMNS 7
-#define DRAM_ROW_SIZE (BLOCK_SIZE*DRAM_COLUMNS/1024)
+// the geometry is set at runtime (config.h), the MAX values bound the arrays of the memory controller
+#define DRAM_MAX_CHANNELS 8
+#define DRAM_MAX_RANKS 8
+#define DRAM_MAX_BANKS 16
+#define DRAM_MAX_ROWS (1<<20) // not an array bound, keeps the DRAM size in range
+extern uint32_t DRAM_CHANNELS, DRAM_RANKS, DRAM_BANKS, DRAM_ROWS, DRAM_COLUMNS,
+                LOG2_DRAM_CHANNELS, LOG2_DRAM_RANKS, LOG2_DRAM_BANKS, LOG2_DRAM_ROWS, LOG2_DRAM_COLUMNS;
+// in KB, MB and pages, computed in 64 bits since the geometry comes from the config file (load_config checks it)
+#define DRAM_ROW_SIZE ((uint64_t)BLOCK_SIZE*DRAM_COLUMNS/1024)
 
 #define DRAM_SIZE (DRAM_CHANNELS*DRAM_RANKS*DRAM_BANKS*DRAM_ROWS*DRAM_ROW_SIZE/1024) 
 #define DRAM_PAGES ((DRAM_SIZE<<10)>>2) 
@@ -79,7 +78,8 @@ extern uint8_t warmup_complete[NUM_CPUS],
                all_simulation_complete,
                MAX_INSTR_DESTINATIONS,
                knob_cloudsuite,
-               knob_low_bandwidth;
+               knob_low_bandwidth,
+               knob_derived_cache;
 
 extern uint64_t current_core_cycle[NUM_CPUS], 
                 stall_cycle[NUM_CPUS], 
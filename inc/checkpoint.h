@@ -0,0 +1,52 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// microarchitectural checkpoints at the end of the warmup (-save_checkpoint FILE, -restore_checkpoint FILE)
+//
+// a checkpoint holds the state that outlives the warmup: cache and TLB blocks, the state of the selected modules,
+// the page tables, the open DRAM rows, and for every core its trace position, retired instructions and cycle.
+// instructions and requests still in flight are not kept, a restored run starts with empty pipelines and queues
+// at the oldest unretired instruction and goes straight to the region of interest.
+// saving and restoring go through the same transfer calls, so every part is written in one place.
+// the data is kept in memory and written gzip-compressed once complete.
+
+#include <vector>
+#include "champsim.h"
+
+#define CHECKPOINT_MAGIC "ChampSim checkpoint"
+#define CHECKPOINT_VERSION 1
+
+class CHECKPOINT {
+  public:
+    const uint8_t restoring;
+
+    CHECKPOINT(uint8_t v1) : restoring(v1), position(0) {};
+
+    void read_file(const char *file),
+         write_file(const char *file);
+
+    // stores the value when saving, overwrites it with the stored one when restoring
+    template <class T> void transfer(T &value) { transfer_bytes(&value, sizeof(T)); };
+    template <class T> void transfer(T *values, uint64_t count) { transfer_bytes(values, count*sizeof(T)); };
+    void transfer(string &value);
+    void transfer(map <uint64_t, uint64_t> &values);
+    void transfer(queue <uint64_t> &values);
+
+    // a part of the checkpoint a restoring run may leave out, e.g. the DRAM rows of another DRAM organization
+    void begin_section(),
+         end_section(),
+         skip_section();
+
+    // a section holding the state of the module selected for kind (module.h),
+    // returns 0 after skipping the section when the checkpoint was saved with another module, which then starts cold
+    uint8_t begin_module(uint32_t kind);
+
+  private:
+    vector <uint8_t> data;
+    uint64_t position;
+    vector <uint64_t> sections; // saving: where the size of each open section goes, restoring: where it ends
+
+    void transfer_bytes(void *bytes, uint64_t size);
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef CHUNKED_TRACE_H
+#define CHUNKED_TRACE_H
+
+// seekable chunked trace container
+//
+// header | chunk 0 | chunk 1 | ... | index
+//
+// every chunk is an independent xz stream holding records_per_chunk fixed-size records (the last one may be shorter),
+// so the body is also a valid multi-stream xz file. the index maps chunk numbers to file offsets.
+// this header only depends on the C library and liblzma so that tools outside the simulator (tracers, converters) can use the writer.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <lzma.h>
+#include <vector>
+
+#define CHUNKED_TRACE_MAGIC "CHMPCHK1"
+#define CHUNKED_TRACE_RECORDS_PER_CHUNK (1<<20)
+#define CHUNKED_TRACE_PRESET 6
+
+class chunked_trace_header {
+  public:
+    char magic[8];
+    uint32_t record_size,
+             records_per_chunk;
+    uint64_t num_records,
+             num_chunks,
+             index_offset;
+
+    chunked_trace_header() {
+        memcpy(magic, CHUNKED_TRACE_MAGIC, sizeof(magic));
+        record_size = 0;
+        records_per_chunk = 0;
+        num_records = 0;
+        num_chunks = 0;
+        index_offset = 0;
+    };
+};
+
+class chunked_trace_index_entry {
+  public:
+    uint64_t offset,       // file offset of the compressed chunk
+             size,         // compressed bytes
+             first_record; // first trace record in the chunk
+};
+
+class CHUNKED_TRACE_WRITER {
+  public:
+    chunked_trace_header header;
+    std::vector <chunked_trace_index_entry> index;
+
+    // file must be seekable, the header is rewritten by finish()
+    // v5 tells readers how chunks are encoded, write_record() only produces CHUNKED_TRACE_MAGIC chunks
+    CHUNKED_TRACE_WRITER(FILE *v1, uint32_t v2, uint32_t v3 = CHUNKED_TRACE_RECORDS_PER_CHUNK, uint32_t v4 = CHUNKED_TRACE_PRESET, const char *v5 = CHUNKED_TRACE_MAGIC) : file(v1), preset(v4) {
+        memcpy(header.magic, v5, sizeof(header.magic));
+        header.record_size = v2;
+        header.records_per_chunk = v3;
+
+        chunk_size = (size_t)header.record_size * header.records_per_chunk;
+        chunk_buffer = new uint8_t[chunk_size];
+        compressed_buffer = new uint8_t[lzma_stream_buffer_bound(chunk_size)];
+        chunk_fill = 0;
+        buffered_records = 0;
+
+        file_offset = sizeof(header);
+        fwrite(&header, sizeof(header), 1, file);
+    };
+
+    ~CHUNKED_TRACE_WRITER() {
+        delete[] chunk_buffer;
+        delete[] compressed_buffer;
+    };
+
+    void write_record(const void *record) {
+        memcpy(chunk_buffer + chunk_fill, record, header.record_size);
+        chunk_fill += header.record_size;
+        buffered_records++;
+
+        if (chunk_fill == chunk_size)
+            flush_chunk();
+    };
+
+    // write the last chunk and the index, then patch the header
+    void finish() {
+        if (chunk_fill)
+            flush_chunk();
+
+        header.num_chunks = index.size();
+        header.index_offset = file_offset;
+        if (index.size())
+            fwrite(&index[0], sizeof(chunked_trace_index_entry), index.size(), file);
+
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+        fflush(file);
+    };
+
+    // compress one chunk worth of records, returns the compressed size
+    // converters use this to compress several chunks in parallel and then append them in order
+    static size_t compress_chunk(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size, uint32_t preset) {
+        size_t out_pos = 0;
+        lzma_ret ret = lzma_easy_buffer_encode(preset, LZMA_CHECK_CRC64, NULL, in, in_size, out, &out_pos, out_size);
+        assert(ret == LZMA_OK);
+
+        return out_pos;
+    };
+
+    // add an already compressed chunk holding num_records records
+    void append_chunk(const uint8_t *compressed, size_t size, uint64_t num_records) {
+        assert(chunk_fill == 0);
+
+        chunked_trace_index_entry entry;
+        entry.offset = file_offset;
+        entry.size = size;
+        entry.first_record = header.num_records;
+        index.push_back(entry);
+
+        fwrite(compressed, 1, size, file);
+        file_offset += size;
+        header.num_records += num_records;
+    };
+
+  private:
+    FILE *file;
+    uint32_t preset;
+    uint8_t *chunk_buffer, *compressed_buffer;
+    size_t chunk_size, chunk_fill;
+    uint64_t file_offset, buffered_records;
+
+    void flush_chunk() {
+        size_t out_pos = compress_chunk(chunk_buffer, chunk_fill, compressed_buffer, lzma_stream_buffer_bound(chunk_size), preset);
+        chunk_fill = 0;
+        append_chunk(compressed_buffer, out_pos, buffered_records);
+        buffered_records = 0;
+    };
+};
+
+// read the header and the index of a chunked trace, returns 0 if the magic does not match or the file is truncated
+inline uint8_t read_chunked_trace_index(FILE *file, const char *magic, chunked_trace_header *header, std::vector <chunked_trace_index_entry> *index)
+{
+    fseek(file, 0, SEEK_SET);
+    if ((fread(header, sizeof(chunked_trace_header), 1, file) != 1) || memcmp(header->magic, magic, sizeof(header->magic)))
+        return 0;
+
+    index->resize(header->num_chunks);
+    fseek(file, header->index_offset, SEEK_SET);
+    if (header->num_chunks && (fread(&(*index)[0], sizeof(chunked_trace_index_entry), header->num_chunks, file) != header->num_chunks))
+        return 0;
+
+    return 1;
+}
+
+// chunk holding the given record, the index must not be empty
+inline uint64_t find_chunk(const std::vector <chunked_trace_index_entry> &index, uint64_t record)
+{
+    uint64_t lo = 0, hi = index.size();
+    while ((hi - lo) > 1) {
+        uint64_t mid = (lo + hi) / 2;
+        if (index[mid].first_record <= record)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef COLUMNAR_TRACE_H
+#define COLUMNAR_TRACE_H
+
+// delta-encoded columnar chunk codec for input_instr traces
+//
+// chunks of the chunked container (chunked_trace.h) written with CHUNKED_TRACE_COLUMNAR_MAGIC hold an xz stream of
+//
+// columnar_chunk_header | flags | memory mask | register slots | ip deltas | memory deltas (one column per slot)
+//
+// flags packs is_branch and branch_taken, the memory mask has one bit per memory slot that is non-zero.
+// ip is delta-encoded against the previous instruction and every memory slot against the last non-zero value of that slot,
+// both zigzag-encoded and stored with the narrowest width (0, 1, 2, 4 or 8 bytes) that fits the whole column.
+// the history restarts at every chunk so that chunks can still be decoded on their own.
+// all columns are fixed-width, so decoding is a handful of branch-free loops the compiler vectorizes.
+
+#include "champsim.h"
+#include "chunked_trace.h"
+#include "instruction.h"
+
+#define CHUNKED_TRACE_COLUMNAR_MAGIC "CHMPCOL1"
+#define COLUMNAR_TRACE_RECORDS_PER_CHUNK (1<<16)
+#define COLUMNAR_TRACE_NUM_REGISTERS (NUM_INSTR_DESTINATIONS + NUM_INSTR_SOURCES)
+#define COLUMNAR_TRACE_NUM_MEMORY (NUM_INSTR_DESTINATIONS + NUM_INSTR_SOURCES)
+
+#define COLUMNAR_FLAG_BRANCH 1
+#define COLUMNAR_FLAG_TAKEN 2
+
+static_assert(COLUMNAR_TRACE_NUM_MEMORY <= 8, "the memory mask holds one bit per memory slot");
+
+class columnar_chunk_header {
+  public:
+    uint32_t num_records;
+    uint8_t ip_width,
+            memory_width[COLUMNAR_TRACE_NUM_MEMORY];
+};
+
+class COLUMNAR_TRACE_CODEC {
+  public:
+    uint32_t max_records;
+
+    COLUMNAR_TRACE_CODEC(uint32_t v1 = COLUMNAR_TRACE_RECORDS_PER_CHUNK) : max_records(v1) {
+        column = new uint64_t[max_records];
+        history = new uint64_t[max_records];
+    };
+
+    ~COLUMNAR_TRACE_CODEC() {
+        delete[] column;
+        delete[] history;
+    };
+
+    // upper bound of the encoded size of num_records records
+    static size_t encoded_bound(uint32_t num_records) {
+        return sizeof(columnar_chunk_header) + (size_t)num_records * (2 + COLUMNAR_TRACE_NUM_REGISTERS + 8 * (1 + COLUMNAR_TRACE_NUM_MEMORY));
+    };
+
+    // returns the number of bytes written to out
+    size_t encode(const input_instr *records, uint32_t num_records, uint8_t *out) {
+        assert(num_records <= max_records);
+
+        columnar_chunk_header chunk_header;
+        memset(&chunk_header, 0, sizeof(chunk_header));
+        chunk_header.num_records = num_records;
+        uint8_t *pos = out + sizeof(chunk_header);
+
+        // flags and memory mask
+        for (uint32_t i=0; i<num_records; i++) {
+            pos[i] = (records[i].is_branch ? COLUMNAR_FLAG_BRANCH : 0) | (records[i].branch_taken ? COLUMNAR_FLAG_TAKEN : 0);
+
+            uint8_t mask = 0;
+            for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_MEMORY; slot++)
+                if (memory_slot(&records[i], slot))
+                    mask |= (1 << slot);
+            pos[num_records + i] = mask;
+        }
+        pos += 2 * (size_t)num_records;
+
+        // register slots
+        for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_REGISTERS; slot++) {
+            for (uint32_t i=0; i<num_records; i++)
+                pos[i] = (slot < NUM_INSTR_DESTINATIONS) ? records[i].destination_registers[slot] : records[i].source_registers[slot - NUM_INSTR_DESTINATIONS];
+            pos += num_records;
+        }
+
+        // ip deltas
+        uint64_t previous = 0;
+        for (uint32_t i=0; i<num_records; i++) {
+            column[i] = zigzag(records[i].ip - previous);
+            previous = records[i].ip;
+        }
+        chunk_header.ip_width = pack_column(column, num_records, pos);
+        pos += (size_t)chunk_header.ip_width * num_records;
+
+        // memory deltas against the last non-zero address seen in the same slot
+        for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_MEMORY; slot++) {
+            previous = 0;
+            for (uint32_t i=0; i<num_records; i++) {
+                uint64_t address = memory_slot(&records[i], slot);
+                column[i] = address ? zigzag(address - previous) : 0;
+                if (address)
+                    previous = address;
+            }
+            chunk_header.memory_width[slot] = pack_column(column, num_records, pos);
+            pos += (size_t)chunk_header.memory_width[slot] * num_records;
+        }
+
+        memcpy(out, &chunk_header, sizeof(chunk_header));
+
+        return pos - out;
+    };
+
+    // returns the number of records decoded, 0 if the chunk is malformed
+    uint32_t decode(const uint8_t *in, size_t in_size, input_instr *records) {
+        columnar_chunk_header chunk_header;
+        if (in_size < sizeof(chunk_header))
+            return 0;
+        memcpy(&chunk_header, in, sizeof(chunk_header));
+
+        uint32_t num_records = chunk_header.num_records;
+        size_t expected = sizeof(chunk_header) + (size_t)num_records * (2 + COLUMNAR_TRACE_NUM_REGISTERS + chunk_header.ip_width);
+        for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_MEMORY; slot++)
+            expected += (size_t)num_records * chunk_header.memory_width[slot];
+        if ((num_records > max_records) || (expected != in_size))
+            return 0;
+
+        const uint8_t *flags = in + sizeof(chunk_header),
+                      *mask = flags + num_records,
+                      *registers = mask + num_records,
+                      *pos = registers + (size_t)COLUMNAR_TRACE_NUM_REGISTERS * num_records;
+
+        for (uint32_t i=0; i<num_records; i++) {
+            records[i].is_branch = (flags[i] & COLUMNAR_FLAG_BRANCH) ? 1 : 0;
+            records[i].branch_taken = (flags[i] & COLUMNAR_FLAG_TAKEN) ? 1 : 0;
+        }
+
+        for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_REGISTERS; slot++) {
+            const uint8_t *source = registers + (size_t)slot * num_records;
+            if (slot < NUM_INSTR_DESTINATIONS) {
+                for (uint32_t i=0; i<num_records; i++)
+                    records[i].destination_registers[slot] = source[i];
+            }
+            else {
+                for (uint32_t i=0; i<num_records; i++)
+                    records[i].source_registers[slot - NUM_INSTR_DESTINATIONS] = source[i];
+            }
+        }
+
+        unpack_deltas(pos, chunk_header.ip_width, num_records);
+        pos += (size_t)chunk_header.ip_width * num_records;
+        for (uint32_t i=0; i<num_records; i++)
+            records[i].ip = history[i];
+
+        for (uint32_t slot=0; slot<COLUMNAR_TRACE_NUM_MEMORY; slot++) {
+            unpack_deltas(pos, chunk_header.memory_width[slot], num_records);
+            pos += (size_t)chunk_header.memory_width[slot] * num_records;
+
+            // absent operands have a zero delta, so the running sum is the last address of the slot
+            if (slot < NUM_INSTR_DESTINATIONS) {
+                for (uint32_t i=0; i<num_records; i++)
+                    records[i].destination_memory[slot] = ((mask[i] >> slot) & 1) ? history[i] : 0;
+            }
+            else {
+                for (uint32_t i=0; i<num_records; i++)
+                    records[i].source_memory[slot - NUM_INSTR_DESTINATIONS] = ((mask[i] >> slot) & 1) ? history[i] : 0;
+            }
+        }
+
+        return num_records;
+    };
+
+  private:
+    uint64_t *column,   // packed deltas of the column being processed
+             *history;  // running sums of the column being decoded
+
+    static uint64_t zigzag(uint64_t delta) {
+        return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+    };
+
+    static uint64_t unzigzag(uint64_t value) {
+        return (value >> 1) ^ (0 - (value & 1));
+    };
+
+    static uint64_t memory_slot(const input_instr *record, uint32_t slot) {
+        if (slot < NUM_INSTR_DESTINATIONS)
+            return record->destination_memory[slot];
+        return record->source_memory[slot - NUM_INSTR_DESTINATIONS];
+    };
+
+    // store the column with the narrowest width that fits every value, returns the width
+    static uint8_t pack_column(const uint64_t *values, uint32_t num_values, uint8_t *out) {
+        uint64_t all_bits = 0;
+        for (uint32_t i=0; i<num_values; i++)
+            all_bits |= values[i];
+
+        uint8_t width = 8;
+        if (all_bits == 0)
+            width = 0;
+        else if (all_bits <= UINT8_MAX)
+            width = 1;
+        else if (all_bits <= UINT16_MAX)
+            width = 2;
+        else if (all_bits <= UINT32_MAX)
+            width = 4;
+
+        // little-endian hosts only, like the rest of the trace formats
+        for (uint32_t i=0; i<num_values; i++)
+            memcpy(out + (size_t)i * width, &values[i], width);
+
+        return width;
+    };
+
+    template <typename T>
+    void widen_column(const uint8_t *in, uint32_t num_values) {
+        for (uint32_t i=0; i<num_values; i++) {
+            T value;
+            memcpy(&value, in + (size_t)i * sizeof(T), sizeof(T));
+            column[i] = value;
+        }
+    };
+
+    // widen and unzigzag a packed column into history[], then turn the deltas into values
+    void unpack_deltas(const uint8_t *in, uint8_t width, uint32_t num_values) {
+        switch (width) {
+            case 0:
+                memset(column, 0, (size_t)num_values * sizeof(uint64_t));
+                break;
+            case 1:
+                widen_column<uint8_t>(in, num_values);
+                break;
+            case 2:
+                widen_column<uint16_t>(in, num_values);
+                break;
+            case 4:
+                widen_column<uint32_t>(in, num_values);
+                break;
+            default:
+                widen_column<uint64_t>(in, num_values);
+                break;
+        }
+
+        for (uint32_t i=0; i<num_values; i++)
+            history[i] = unzigzag(column[i]);
+
+        uint64_t sum = 0;
+        for (uint32_t i=0; i<num_values; i++) {
+            sum += history[i];
+            history[i] = sum;
+        }
+    };
+};
+
+#endif
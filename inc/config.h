@@ -0,0 +1,18 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// runtime configuration (-config FILE)
+//
+// the core, cache and DRAM parameters that used to be compile-time macros are globals with the same names,
+// so a parameter sweep only needs a config file per point instead of a rebuild.
+// a config file holds one "NAME = VALUE" line per parameter, NAME being the old macro name (e.g. ROB_SIZE, LLC_WAY),
+// '#' and ';' start comments and "[section]" lines are only there for readability.
+// NUM_CPUS, BLOCK_SIZE and PAGE_SIZE are still fixed at build time.
+
+#include "ooo_cpu.h"
+#include "dram_controller.h"
+
+// set the parameters named in file, the rest keep their defaults
+void load_config(const char *file);
+
+#endif
@@ -3,14 +3,14 @@
 
 #include "memory_class.h"
 
+class CHECKPOINT;
+
 // DRAM configuration
 #define DRAM_CHANNEL_WIDTH 8 // 8B
-#define DRAM_WQ_SIZE 64
-#define DRAM_RQ_SIZE 64
 
-#define tRP_DRAM_NANOSECONDS  12.5
-#define tRCD_DRAM_NANOSECONDS 12.5
-#define tCAS_DRAM_NANOSECONDS 12.5
+// queue sizes and timing, set at runtime (config.h)
+extern uint32_t DRAM_WQ_SIZE, DRAM_RQ_SIZE;
+extern double tRP_DRAM_NANOSECONDS, tRCD_DRAM_NANOSECONDS, tCAS_DRAM_NANOSECONDS;
 
 // the data bus must wait this amount of time when switching between reads and writes, and vice versa
 #define DRAM_DBUS_TURN_AROUND_TIME ((15*CPU_FREQ)/2000) // 7.5 ns 
@@ -26,17 +26,17 @@ class MEMORY_CONTROLLER : public MEMORY {
   public:
     const string NAME;
 
-    DRAM_ARRAY dram_array[DRAM_CHANNELS][DRAM_RANKS][DRAM_BANKS];
-    uint64_t dbus_cycle_available[DRAM_CHANNELS], dbus_cycle_congested[DRAM_CHANNELS], dbus_congested[NUM_TYPES+1][NUM_TYPES+1];
-    uint64_t bank_cycle_available[DRAM_CHANNELS][DRAM_RANKS][DRAM_BANKS];
-    uint8_t  do_write, write_mode[DRAM_CHANNELS]; 
-    uint32_t processed_writes, scheduled_reads[DRAM_CHANNELS], scheduled_writes[DRAM_CHANNELS];
+    DRAM_ARRAY dram_array[DRAM_MAX_CHANNELS][DRAM_MAX_RANKS][DRAM_MAX_BANKS];
+    uint64_t dbus_cycle_available[DRAM_MAX_CHANNELS], dbus_cycle_congested[DRAM_MAX_CHANNELS], dbus_congested[NUM_TYPES+1][NUM_TYPES+1];
+    uint64_t bank_cycle_available[DRAM_MAX_CHANNELS][DRAM_MAX_RANKS][DRAM_MAX_BANKS];
+    uint8_t  do_write, write_mode[DRAM_MAX_CHANNELS]; 
+    uint32_t processed_writes, scheduled_reads[DRAM_MAX_CHANNELS], scheduled_writes[DRAM_MAX_CHANNELS];
     int fill_level;
 
-    BANK_REQUEST bank_request[DRAM_CHANNELS][DRAM_RANKS][DRAM_BANKS];
+    BANK_REQUEST bank_request[DRAM_MAX_CHANNELS][DRAM_MAX_RANKS][DRAM_MAX_BANKS];
 
     // queues
-    PACKET_QUEUE WQ[DRAM_CHANNELS], RQ[DRAM_CHANNELS];
+    PACKET_QUEUE WQ[DRAM_MAX_CHANNELS], RQ[DRAM_MAX_CHANNELS];
 
     // constructor
     MEMORY_CONTROLLER(string v1) : NAME (v1) {
@@ -83,7 +83,8 @@ class MEMORY_CONTROLLER : public MEMORY {
 
     void return_data(PACKET *packet),
          operate(),
-         increment_WQ_FULL(uint64_t address);
+         increment_WQ_FULL(uint64_t address),
+         functional_access(PACKET *packet);
 
     uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
              get_size(uint8_t queue_type, uint64_t address);
@@ -100,9 +101,12 @@ class MEMORY_CONTROLLER : public MEMORY {
              dram_get_column (uint64_t address),
              drc_check_hit (uint64_t address, uint32_t cpu, uint32_t channel, uint32_t rank, uint32_t bank, uint32_t row);
 
-    uint64_t get_bank_earliest_cycle();
+    uint64_t get_bank_earliest_cycle(),
+             next_operate_cycle(uint64_t cycle);
 
     int check_dram_queue(PACKET_QUEUE *queue, PACKET *packet);
+
+    void checkpoint(CHECKPOINT &checkpoint);
 };
 
 #endif
@@ -3,9 +3,7 @@
 
 
 // instruction format
-#define ROB_SIZE 352
-#define LQ_SIZE 128
-#define SQ_SIZE 72
+extern uint32_t ROB_SIZE, LQ_SIZE, SQ_SIZE; // set at runtime (config.h), at most MAX_SIZE of set.h
 #define NUM_INSTR_DESTINATIONS_SPARC 4
 #define NUM_INSTR_DESTINATIONS 2
 #define NUM_INSTR_SOURCES 4
@@ -165,6 +163,11 @@ class ooo_model_instr {
     //uint8_t memory_instrs_depend_on_me[ROB_SIZE];
     fastset memory_instrs_depend_on_me;
 
+    // rename table links set at dispatch (O3_CPU::add_to_rob), the rob index and instr_id of
+    // the last older instruction writing each source register and each destination register
+    uint32_t source_writer[NUM_INSTR_SOURCES], previous_writer[NUM_INSTR_DESTINATIONS_SPARC];
+    uint64_t source_writer_id[NUM_INSTR_SOURCES], previous_writer_id[NUM_INSTR_DESTINATIONS_SPARC];
+
     uint32_t lq_index[NUM_INSTR_SOURCES],
              sq_index[NUM_INSTR_DESTINATIONS_SPARC],
              forwarding_index[NUM_INSTR_DESTINATIONS_SPARC];
@@ -217,6 +220,8 @@ class ooo_model_instr {
             source_added[i] = 0;
             lq_index[i] = UINT32_MAX;
             reg_RAW_checked[i] = 0;
+            source_writer[i] = UINT32_MAX;
+            source_writer_id[i] = 0;
         }
 
         for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS_SPARC; i++) {
@@ -226,6 +231,8 @@ class ooo_model_instr {
             destination_added[i] = 0;
             sq_index[i] = UINT32_MAX;
             forwarding_index[i] = 0;
+            previous_writer[i] = UINT32_MAX;
+            previous_writer_id[i] = 0;
         }
 
 #if 0
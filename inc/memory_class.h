@@ -35,6 +35,9 @@ class MEMORY {
     virtual uint32_t get_occupancy(uint8_t queue_type, uint64_t address) = 0;
     virtual uint32_t get_size(uint8_t queue_type, uint64_t address) = 0;
 
+    // functional warmup, the access completes at once without queues or timing
+    virtual void functional_access(PACKET *packet) = 0;
+
     // stats
     uint64_t ACCESS[NUM_TYPES], HIT[NUM_TYPES], MISS[NUM_TYPES], MSHR_MERGED[NUM_TYPES], STALL[NUM_TYPES];
 
@@ -0,0 +1,95 @@
+#ifndef MODULE_H
+#define MODULE_H
+
+// runtime-selectable modules (-branch_predictor, -l1i_prefetcher, -l1d_prefetcher, -l2c_prefetcher, -llc_prefetcher, -llc_replacement)
+//
+// every branch/*.bpred, prefetcher/*.{l1i,l1d,l2c,llc}_pref and replacement/*.llc_repl file is built into the binary.
+// the Makefile compiles each one on its own, renames the entry points it defines after the module
+// (O3_CPU::predict_branch of gshare.bpred becomes O3_CPU::predict_branch_gshare) and hides all its other symbols,
+// so the tables of two modules never clash.
+// module_list.h, generated by the Makefile, lists the modules of each kind, e.g. BRANCH_PREDICTORS(f) f(bimodal) f(gshare) ...
+// the original entry points (src/module.cc) switch on the selected module and call its version directly, no virtual calls.
+// the checkpoint entry point (checkpoint.h) is optional, a module without one cannot be saved or restored.
+// so is l1i_prefetcher_cycle_idle, idle cycles are only skipped when the L1I prefetcher defines it.
+
+#include <stdint.h>
+#include "module_list.h"
+
+class CHECKPOINT;
+
+#define MODULE_BRANCH_PREDICTOR 0
+#define MODULE_L1I_PREFETCHER 1
+#define MODULE_L1D_PREFETCHER 2
+#define MODULE_L2C_PREFETCHER 3
+#define MODULE_LLC_PREFETCHER 4
+#define MODULE_LLC_REPLACEMENT 5
+#define NUM_MODULE_KINDS 6
+
+// module ids, in module_list.h order
+#define BRANCH_PREDICTOR_ID(name) BRANCH_PREDICTOR_##name,
+#define L1I_PREFETCHER_ID(name) L1I_PREFETCHER_##name,
+#define L1D_PREFETCHER_ID(name) L1D_PREFETCHER_##name,
+#define L2C_PREFETCHER_ID(name) L2C_PREFETCHER_##name,
+#define LLC_PREFETCHER_ID(name) LLC_PREFETCHER_##name,
+#define LLC_REPLACEMENT_ID(name) LLC_REPLACEMENT_##name,
+
+enum { BRANCH_PREDICTORS(BRANCH_PREDICTOR_ID) NUM_BRANCH_PREDICTORS };
+enum { L1I_PREFETCHERS(L1I_PREFETCHER_ID) NUM_L1I_PREFETCHERS };
+enum { L1D_PREFETCHERS(L1D_PREFETCHER_ID) NUM_L1D_PREFETCHERS };
+enum { L2C_PREFETCHERS(L2C_PREFETCHER_ID) NUM_L2C_PREFETCHERS };
+enum { LLC_PREFETCHERS(LLC_PREFETCHER_ID) NUM_LLC_PREFETCHERS };
+enum { LLC_REPLACEMENTS(LLC_REPLACEMENT_ID) NUM_LLC_REPLACEMENTS };
+
+// entry points of every module, expanded inside O3_CPU and CACHE
+#define DECLARE_BRANCH_PREDICTOR(name) \
+    void initialize_branch_predictor_##name(); \
+    uint8_t predict_branch_##name(uint64_t ip); \
+    void last_branch_result_##name(uint64_t ip, uint8_t taken); \
+    void checkpoint_branch_predictor_##name(CHECKPOINT &checkpoint);
+
+#define DECLARE_L1I_PREFETCHER(name) \
+    void l1i_prefetcher_initialize_##name(); \
+    void l1i_prefetcher_branch_operate_##name(uint64_t ip, uint8_t branch_type, uint64_t branch_target); \
+    void l1i_prefetcher_cache_operate_##name(uint64_t v_addr, uint8_t cache_hit, uint8_t prefetch_hit); \
+    void l1i_prefetcher_cycle_operate_##name(); \
+    uint8_t l1i_prefetcher_cycle_idle_##name(); \
+    void l1i_prefetcher_cache_fill_##name(uint64_t v_addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_v_addr); \
+    void l1i_prefetcher_final_stats_##name(); \
+    void l1i_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint);
+
+#define DECLARE_L1D_PREFETCHER(name) \
+    void l1d_prefetcher_initialize_##name(); \
+    void l1d_prefetcher_operate_##name(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type); \
+    void l1d_prefetcher_cache_fill_##name(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in); \
+    void l1d_prefetcher_final_stats_##name(); \
+    void l1d_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint);
+
+#define DECLARE_L2C_PREFETCHER(name) \
+    void l2c_prefetcher_initialize_##name(); \
+    uint32_t l2c_prefetcher_operate_##name(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in); \
+    uint32_t l2c_prefetcher_cache_fill_##name(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in); \
+    void l2c_prefetcher_final_stats_##name(); \
+    void l2c_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint);
+
+#define DECLARE_LLC_PREFETCHER(name) \
+    void llc_prefetcher_initialize_##name(); \
+    uint32_t llc_prefetcher_operate_##name(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in); \
+    uint32_t llc_prefetcher_cache_fill_##name(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in); \
+    void llc_prefetcher_final_stats_##name(); \
+    void llc_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint);
+
+#define DECLARE_LLC_REPLACEMENT(name) \
+    void llc_initialize_replacement_##name(); \
+    uint32_t llc_find_victim_##name(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type); \
+    void llc_update_replacement_state_##name(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit); \
+    void llc_replacement_final_stats_##name(); \
+    void llc_replacement_checkpoint_##name(CHECKPOINT &checkpoint);
+
+// selected module id of every kind
+extern uint32_t selected_module[NUM_MODULE_KINDS];
+
+// select a module by its file name without extension, an unknown name stops with the list of choices
+void select_module(uint32_t kind, const char *name);
+const char *selected_module_name(uint32_t kind);
+
+#endif
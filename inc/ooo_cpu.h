@@ -2,6 +2,7 @@
 #define OOO_CPU_H
 
 #include "cache.h"
+#include "tracedecoder.h"
 
 #ifdef CRC2_COMPILE
 #define STAT_PRINTING_PERIOD 1000000
@@ -13,36 +14,43 @@
 using namespace std;
 
 // CORE PROCESSOR
-#define FETCH_WIDTH 6
-#define DECODE_WIDTH 6
-#define EXEC_WIDTH 6
-#define LQ_WIDTH 2
-#define SQ_WIDTH 2
-#define RETIRE_WIDTH 4
-#define SCHEDULER_SIZE 128
-#define BRANCH_MISPREDICT_PENALTY 1
+// set at runtime (config.h)
+extern uint32_t FETCH_WIDTH, DECODE_WIDTH, EXEC_WIDTH, LQ_WIDTH, SQ_WIDTH, RETIRE_WIDTH,
+                SCHEDULER_SIZE, BRANCH_MISPREDICT_PENALTY;
 //#define SCHEDULING_LATENCY 0
 //#define EXEC_LATENCY 0
 //#define DECODE_LATENCY 2
 
 #define STA_SIZE (ROB_SIZE*NUM_INSTR_DESTINATIONS_SPARC)
+#define NUM_ARCH_REGISTERS 256 // register ids are 8 bits
 
 extern uint32_t SCHEDULING_LATENCY, EXEC_LATENCY, DECODE_LATENCY;
 
+// a ROB entry that may complete at event_cycle, see O3_CPU::add_completion_event
+class completion_event {
+  public:
+    uint64_t event_cycle, instr_id;
+    uint32_t rob_index;
+
+    completion_event(uint64_t v1, uint64_t v2, uint32_t v3) : event_cycle(v1), instr_id(v2), rob_index(v3) {};
+
+    // earliest first in a priority_queue
+    bool operator<(const completion_event &other) const { return event_cycle > other.event_cycle; };
+};
+
 // cpu
 class O3_CPU {
   public:
     uint32_t cpu;
 
     // trace
-    FILE *trace_file;
+    TRACE_DECODER *trace_decoder;
     char trace_string[1024];
-    char gunzip_command[1024];
+    uint64_t trace_first_record, trace_first_instr_id; // instruction trace_first_instr_id is record trace_first_record of the trace
+    vector <uint64_t> trace_rewinds; // instr_id of every instruction read right after the trace wrapped around
+    uint64_t functional_fetch_block; // virtual block of the last instruction fetch in functional warmup
 
     // instruction
-    input_instr next_instr;
-    input_instr current_instr;
-    cloudsuite_instr current_cloudsuite_instr;
     uint64_t instr_unique_id, completed_executions, 
              begin_sim_cycle, begin_sim_instr, 
              last_sim_cycle, last_sim_instr,
@@ -50,6 +58,10 @@ class O3_CPU {
              warmup_instructions, simulation_instructions, instrs_to_read_this_cycle, instrs_to_fetch_this_cycle,
              next_print_instruction, num_retired;
     uint32_t inflight_reg_executions, inflight_mem_executions, num_searched;
+
+    // executing instructions by completion cycle, so update_rob only visits the ones that complete
+    priority_queue <completion_event> completion_events;
+    vector <uint32_t> completing; // rob indices completing this cycle
     uint32_t next_ITLB_fetch;
 
     // reorder buffer, load/store queue, register file
@@ -58,20 +70,28 @@ class O3_CPU {
     CORE_BUFFER ROB{"ROB", ROB_SIZE};
     LOAD_STORE_QUEUE LQ{"LQ", LQ_SIZE}, SQ{"SQ", SQ_SIZE};
 
+    // rename table, rob index and instr_id of the youngest instruction in the ROB writing each register
+    uint32_t register_writer[NUM_ARCH_REGISTERS];
+    uint64_t register_writer_id[NUM_ARCH_REGISTERS];
+
     // store array, this structure is required to properly handle store instructions
-    uint64_t STA[STA_SIZE], STA_head, STA_tail; 
+    uint64_t *STA, STA_head, STA_tail; 
+
+    // stores in the ROB by virtual address, chained hash of store slots (rob_index*NUM_INSTR_DESTINATIONS_SPARC + data_index),
+    // every chain lists the youngest store first
+    uint32_t *store_bucket, *store_next, store_bucket_bits;
 
     // Ready-To-Execute
-    uint32_t RTE0[ROB_SIZE], RTE0_head, RTE0_tail, 
-             RTE1[ROB_SIZE], RTE1_head, RTE1_tail;  
+    uint32_t *RTE0, RTE0_head, RTE0_tail, 
+             *RTE1, RTE1_head, RTE1_tail;  
 
     // Ready-To-Load
-    uint32_t RTL0[LQ_SIZE], RTL0_head, RTL0_tail, 
-             RTL1[LQ_SIZE], RTL1_head, RTL1_tail;  
+    uint32_t *RTL0, RTL0_head, RTL0_tail, 
+             *RTL1, RTL1_head, RTL1_tail;  
 
     // Ready-To-Store
-    uint32_t RTS0[SQ_SIZE], RTS0_head, RTS0_tail,
-             RTS1[SQ_SIZE], RTS1_head, RTS1_tail;
+    uint32_t *RTS0, RTS0_head, RTS0_tail,
+             *RTS1, RTS1_head, RTS1_tail;
 
     // branch
     int branch_mispredict_stall_fetch; // flag that says that we should stall because a branch prediction was wrong
@@ -97,7 +117,10 @@ class O3_CPU {
         cpu = 0;
 
         // trace
-        trace_file = NULL;
+        trace_decoder = NULL;
+        trace_first_record = 0;
+        trace_first_instr_id = 0;
+        functional_fetch_block = 0;
 
         // instruction
         instr_unique_id = 0;
@@ -122,6 +145,11 @@ class O3_CPU {
 
         next_ITLB_fetch = 0;
 
+        for (uint32_t i=0; i<NUM_ARCH_REGISTERS; i++) {
+            register_writer[i] = UINT32_MAX;
+            register_writer_id[i] = 0;
+        }
+
         // branch
         branch_mispredict_stall_fetch = 0;
         mispredicted_branch_iw_index = 0;
@@ -134,11 +162,24 @@ class O3_CPU {
 	    total_branch_types[i] = 0;
 	  }
 	
+        STA = new uint64_t[STA_SIZE];
         for (uint32_t i=0; i<STA_SIZE; i++)
 	  STA[i] = UINT64_MAX;
         STA_head = 0;
         STA_tail = 0;
 
+        store_bucket_bits = 1;
+        while ((1u << store_bucket_bits) < STA_SIZE)
+            store_bucket_bits++;
+        store_bucket = new uint32_t[1 << store_bucket_bits];
+        for (uint32_t i=0; i<(1u << store_bucket_bits); i++)
+            store_bucket[i] = UINT32_MAX;
+        store_next = new uint32_t[STA_SIZE];
+        for (uint32_t i=0; i<STA_SIZE; i++)
+            store_next[i] = UINT32_MAX;
+
+        RTE0 = new uint32_t[ROB_SIZE];
+        RTE1 = new uint32_t[ROB_SIZE];
         for (uint32_t i=0; i<ROB_SIZE; i++) {
 	  RTE0[i] = ROB_SIZE;
 	  RTE1[i] = ROB_SIZE;
@@ -148,6 +189,10 @@ class O3_CPU {
         RTE0_tail = 0;
         RTE1_tail = 0;
 
+        LQ.slots = new QUEUE_SLOTS(LQ_SIZE);
+
+        RTL0 = new uint32_t[LQ_SIZE];
+        RTL1 = new uint32_t[LQ_SIZE];
         for (uint32_t i=0; i<LQ_SIZE; i++) {
 	  RTL0[i] = LQ_SIZE;
 	  RTL1[i] = LQ_SIZE;
@@ -157,6 +202,8 @@ class O3_CPU {
         RTL0_tail = 0;
         RTL1_tail = 0;
 
+        RTS0 = new uint32_t[SQ_SIZE];
+        RTS1 = new uint32_t[SQ_SIZE];
         for (uint32_t i=0; i<SQ_SIZE; i++) {
 	  RTS0[i] = SQ_SIZE;
 	  RTS1[i] = SQ_SIZE;
@@ -180,6 +227,7 @@ class O3_CPU {
          do_execution(uint32_t rob_index),
          do_memory_scheduling(uint32_t rob_index),
          operate_lsq(),
+         add_completion_event(uint32_t rob_index),
          complete_execution(uint32_t rob_index),
          reg_RAW_dependency(uint32_t prior, uint32_t current, uint32_t source_index),
          reg_RAW_release(uint32_t rob_index),
@@ -197,7 +245,11 @@ class O3_CPU {
          execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_index);
     int  execute_load(uint32_t rob_index, uint32_t sq_index, uint32_t data_index);
     void check_dependency(int prior, int current);
+    void add_store_addresses(uint32_t rob_index),
+         remove_store_addresses(uint32_t rob_index);
+    uint32_t store_hash(uint64_t address) { return (address * 0x9E3779B97F4A7C15ULL) >> (64 - store_bucket_bits); };
     void operate_cache();
+    uint64_t next_operate_cycle();
     void update_rob();
     void retire_rob();
 
@@ -209,21 +261,34 @@ class O3_CPU {
 
     uint32_t check_and_add_lsq(uint32_t rob_index);
 
+    // functional warmup, one instruction through the branch predictor, caches and TLBs without timing
+    void functional_instruction();
+
+    // checkpoint.h
+    uint64_t trace_record(uint64_t instr_id);
+    void checkpoint(CHECKPOINT &checkpoint);
+
     // branch predictor
     uint8_t predict_branch(uint64_t ip);
     void    initialize_branch_predictor(),
-            last_branch_result(uint64_t ip, uint8_t taken);
+            last_branch_result(uint64_t ip, uint8_t taken),
+            checkpoint_branch_predictor(CHECKPOINT &checkpoint);
 
   // code prefetching
   void l1i_prefetcher_initialize();
   void l1i_prefetcher_branch_operate(uint64_t ip, uint8_t branch_type, uint64_t branch_target);
   void l1i_prefetcher_cache_operate(uint64_t v_addr, uint8_t cache_hit, uint8_t prefetch_hit);
   void l1i_prefetcher_cycle_operate();
+  uint8_t l1i_prefetcher_cycle_idle(); // 1 when l1i_prefetcher_cycle_operate() has nothing to do
   void l1i_prefetcher_cache_fill(uint64_t v_addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_v_addr);
   void l1i_prefetcher_final_stats();
+  void l1i_prefetcher_checkpoint(CHECKPOINT &checkpoint);
   int prefetch_code_line(uint64_t pf_v_addr); 
+
+  BRANCH_PREDICTORS(DECLARE_BRANCH_PREDICTOR)
+  L1I_PREFETCHERS(DECLARE_L1I_PREFETCHER)
 };
 
-extern O3_CPU ooo_cpu[NUM_CPUS];
+extern O3_CPU *ooo_cpu;
 
 #endif
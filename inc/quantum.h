@@ -0,0 +1,199 @@
+#ifndef QUANTUM_H
+#define QUANTUM_H
+
+// parallel multi-core simulation (-quantum)
+//
+// every core runs with its private caches on its own host thread for a quantum of cycles,
+// then the main thread replays the same cycles of the shared LLC and DRAM.
+// the L2C of a core talks to an LLC_PORT instead of the LLC: requests are buffered with the cycle they were issued in
+// and handed to the LLC in (cycle, cpu) order during the replay, so results only depend on the quantum, not on the host.
+// the LLC returns data straight to the L2C while the cores are parked, which they see in the next quantum.
+// each core only sees its share of the free LLC queue entries (begin_quantum), so not even a quantum of 1 cycle
+// reproduces the serial loop, where a core sees the requests the cores before it added in the same cycle.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "cache.h"
+
+class llc_request {
+  public:
+    uint8_t queue_type; // 1: RQ, 2: WQ, 3: PQ, as in get_occupancy()
+    uint64_t cycle;
+    PACKET packet;
+};
+
+class LLC_PORT : public MEMORY {
+  public:
+    CACHE *llc;
+    deque <llc_request> requests;
+    uint32_t available[4], // LLC queue entries this core may fill in the current quantum
+             used[4];
+    uint64_t wq_full;
+
+    LLC_PORT() {
+        llc = NULL;
+        wq_full = 0;
+        for (uint32_t i=0; i<4; i++) {
+            available[i] = 0;
+            used[i] = 0;
+        }
+    };
+
+    int add_rq(PACKET *packet) { return add_request(1, packet); };
+    int add_wq(PACKET *packet) { return add_request(2, packet); };
+    int add_pq(PACKET *packet) { return add_request(3, packet); };
+
+    // the LLC returns data to the L2C directly
+    void return_data(PACKET *packet) {
+        cerr << "[LLC_PORT] " << __func__ << " instr_id: " << packet->instr_id << endl;
+        assert(0);
+    };
+
+    void operate() {};
+
+    // functional warmup runs before the core threads start, nothing to order
+    void functional_access(PACKET *packet) {
+        llc->functional_access(packet);
+    };
+
+    void increment_WQ_FULL(uint64_t address) {
+        wq_full++;
+    };
+
+    // the L2C sees a queue as full once this core used up its share
+    uint32_t get_occupancy(uint8_t queue_type, uint64_t address) {
+        if (queue_type == 0)
+            return llc->get_occupancy(0, address);
+        return llc->get_size(queue_type, address) - available[queue_type] + used[queue_type];
+    };
+
+    uint32_t get_size(uint8_t queue_type, uint64_t address) {
+        return llc->get_size(queue_type, address);
+    };
+
+    // split the free LLC queue entries evenly between the cores, requests still waiting keep their entries
+    void begin_quantum(uint32_t cpu) {
+        for (uint32_t i=1; i<4; i++) {
+            uint32_t free_entries = llc->get_size(i, 0) - llc->get_occupancy(i, 0);
+            available[i] = free_entries / NUM_CPUS + ((cpu < (free_entries % NUM_CPUS)) ? 1 : 0);
+            used[i] = 0;
+        }
+
+        for (uint32_t i=0; i<requests.size(); i++) {
+            uint8_t queue_type = requests[i].queue_type;
+            available[queue_type]++;
+            used[queue_type]++;
+        }
+    };
+
+    // hand every request issued up to cycle to the LLC, a request that finds its LLC queue full retries in the next cycle
+    void deliver(uint64_t cycle) {
+        llc->WQ.FULL += wq_full;
+        wq_full = 0;
+
+        while (requests.size() && (requests.front().cycle <= cycle)) {
+            llc_request &request = requests.front();
+            if (llc->get_occupancy(request.queue_type, request.packet.address) == llc->get_size(request.queue_type, request.packet.address))
+                break;
+
+            if (request.queue_type == 1)
+                llc->add_rq(&request.packet);
+            else if (request.queue_type == 2)
+                llc->add_wq(&request.packet);
+            else
+                llc->add_pq(&request.packet);
+
+            requests.pop_front();
+        }
+    };
+
+  private:
+    // read misses are added without checking the LLC RQ, which is sized for every L2C MSHR, so a share can run over
+    int add_request(uint8_t queue_type, PACKET *packet) {
+        used[queue_type]++;
+        if (used[queue_type] > available[queue_type])
+            available[queue_type] = used[queue_type];
+
+        llc_request request;
+        request.queue_type = queue_type;
+        request.cycle = current_core_cycle[packet->cpu];
+        request.packet = *packet;
+        requests.push_back(request);
+
+        return -1;
+    };
+};
+
+// cycle each core thread is working on, for the page table turns of va_to_pa() (main.cc)
+// a waiting core spins for a short while, then sleeps until a core it waits for moves on,
+// so more core threads than host CPUs do not burn the time of the ones they wait for
+#define PROGRESS_SPIN 1024
+
+class CORE_PROGRESS {
+  public:
+    CORE_PROGRESS() {
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            cycle[i] = 0;
+            wanted[i] = UINT64_MAX;
+        }
+    };
+
+    void set(uint32_t cpu, uint64_t value) {
+        cycle[cpu].store(value);
+        if (value >= wanted[cpu].load()) {
+            lock_guard <mutex> lock(progress_mutex);
+            wanted[cpu] = UINT64_MAX;
+            advanced.notify_all();
+        }
+    };
+
+    // returns once core cpu is at value or past it
+    void wait(uint32_t cpu, uint64_t value) {
+        for (uint32_t i=0; i<PROGRESS_SPIN; i++) {
+            if (cycle[cpu].load() >= value)
+                return;
+        }
+
+        unique_lock <mutex> lock(progress_mutex);
+        advanced.wait(lock, [&] {
+            if (wanted[cpu].load() > value)
+                wanted[cpu] = value;
+            return cycle[cpu].load() >= value;
+        });
+    };
+
+  private:
+    atomic <uint64_t> cycle[NUM_CPUS],
+                      wanted[NUM_CPUS]; // lowest cycle a sleeping core waits for, set() only wakes it from there on
+    mutex progress_mutex;
+    condition_variable advanced;
+};
+
+// all core threads and the main thread meet here at both ends of a quantum
+class QUANTUM_BARRIER {
+  public:
+    QUANTUM_BARRIER(uint32_t v1) : num_threads(v1), num_waiting(0), generation(0) {};
+
+    void wait() {
+        unique_lock <mutex> lock(barrier_mutex);
+        uint64_t current_generation = generation;
+        if (++num_waiting == num_threads) {
+            num_waiting = 0;
+            generation++;
+            released.notify_all();
+        }
+        else
+            released.wait(lock, [&] { return generation != current_generation; });
+    };
+
+  private:
+    const uint32_t num_threads;
+    uint32_t num_waiting;
+    uint64_t generation;
+    mutex barrier_mutex;
+    condition_variable released;
+};
+
+#endif
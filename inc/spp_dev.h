@@ -57,12 +57,6 @@ class SIGNATURE_TABLE {
              lru[ST_SET][ST_WAY];
 
     SIGNATURE_TABLE() {
-        cout << "Initialize SIGNATURE TABLE" << endl;
-        cout << "ST_SET: " << ST_SET << endl;
-        cout << "ST_WAY: " << ST_WAY << endl;
-        cout << "ST_TAG_BIT: " << ST_TAG_BIT << endl;
-        cout << "ST_TAG_MASK: " << hex << ST_TAG_MASK << dec << endl;
-
         for (uint32_t set = 0; set < ST_SET; set++)
             for (uint32_t way = 0; way < ST_WAY; way++) {
                 valid[set][way] = 0;
@@ -73,7 +67,7 @@ class SIGNATURE_TABLE {
             }
     };
 
-    void read_and_update_sig(uint64_t page, uint32_t page_offset, uint32_t &last_sig, uint32_t &curr_sig, int32_t &delta);
+    void read_and_update_sig(uint64_t page, uint32_t page_offset, uint32_t &last_sig, uint32_t &curr_sig, int32_t &delta, uint32_t cpu);
 };
 
 class PATTERN_TABLE {
@@ -83,13 +77,6 @@ class PATTERN_TABLE {
              c_sig[PT_SET];
 
     PATTERN_TABLE() {
-        cout << endl << "Initialize PATTERN TABLE" << endl;
-        cout << "PT_SET: " << PT_SET << endl;
-        cout << "PT_WAY: " << PT_WAY << endl;
-        cout << "SIG_DELTA_BIT: " << SIG_DELTA_BIT << endl;
-        cout << "C_SIG_BIT: " << C_SIG_BIT << endl;
-        cout << "C_DELTA_BIT: " << C_DELTA_BIT << endl;
-
         for (uint32_t set = 0; set < PT_SET; set++) {
             for (uint32_t way = 0; way < PT_WAY; way++) {
                 delta[set][way] = 0;
@@ -100,7 +87,7 @@ class PATTERN_TABLE {
     }
 
     void update_pattern(uint32_t last_sig, int curr_delta),
-         read_pattern(uint32_t curr_sig, int *prefetch_delta, uint32_t *confidence_q, uint32_t &lookahead_way, uint32_t &lookahead_conf, uint32_t &pf_q_tail, uint32_t &depth);
+         read_pattern(uint32_t curr_sig, int *prefetch_delta, uint32_t *confidence_q, uint32_t &lookahead_way, uint32_t &lookahead_conf, uint32_t &pf_q_tail, uint32_t &depth, uint32_t cpu);
 };
 
 class PREFETCH_FILTER {
@@ -110,9 +97,6 @@ class PREFETCH_FILTER {
              useful[FILTER_SET]; // Consider this as "used"
 
     PREFETCH_FILTER() {
-        cout << endl << "Initialize PREFETCH FILTER" << endl;
-        cout << "FILTER_SET: " << FILTER_SET << endl;
-
         for (uint32_t set = 0; set < FILTER_SET; set++) {
             remainder_tag[set] = 0;
             valid[set] = 0;
@@ -121,7 +105,7 @@ class PREFETCH_FILTER {
 
     }
 
-    bool     check(uint64_t pf_addr, FILTER_REQUEST filter_request);
+    bool     check(uint64_t pf_addr, FILTER_REQUEST filter_request, uint32_t cpu);
 };
 
 class GLOBAL_REGISTER {
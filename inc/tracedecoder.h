@@ -0,0 +1,110 @@
+#ifndef TRACEDECODER_H
+#define TRACEDECODER_H
+
+#include <atomic>
+#include <thread>
+#include "tracereader.h"
+#include "instruction.h"
+
+#define TRACE_BATCH_SIZE 1024 // instructions converted per batch
+#define TRACE_RING_SIZE 8     // batches in flight between the decoder thread and the core, power of 2
+
+// fields ChampSim derives from a trace record and the record after it, stored in the derived cache sidecar
+// (TRACE.derived.raw, one entry per trace record, built by scripts/build_derived_cache.cc)
+class derived_instr {
+  public:
+    uint64_t branch_target;
+    uint8_t is_branch,
+            branch_taken,
+            branch_type,
+            num_reg_ops,
+            num_mem_ops,
+            is_memory,
+            reserved[2];
+
+    derived_instr() {
+        memset(this, 0, sizeof(derived_instr));
+    };
+};
+
+// a batch of trace records already converted into the performance model's instruction format
+class TRACE_BATCH {
+  public:
+    ooo_model_instr entry[TRACE_BATCH_SIZE];
+    uint8_t rewound[TRACE_BATCH_SIZE]; // the trace wrapped around right before this instruction
+    uint32_t count;
+
+    TRACE_BATCH() {
+        count = 0;
+        for (uint32_t i=0; i<TRACE_BATCH_SIZE; i++)
+            rewound[i] = 0;
+    };
+};
+
+// background trace decoder
+// one producer thread per core decompresses and converts records, the core consumes them through a single-producer/single-consumer ring
+class TRACE_DECODER {
+  public:
+    TRACE_READER *reader,
+                 *derived_reader; // derived cache of the trace, NULL when every record is classified on the fly
+
+    TRACE_DECODER(TRACE_READER *v1, TRACE_READER *v2 = NULL);
+    ~TRACE_DECODER();
+
+    void start(),
+         stop();
+
+    // called by the simulator thread, the returned entry stays valid until the next call
+    ooo_model_instr *next_instr(uint8_t *rewound) {
+        if ((consumer_batch == NULL) || (batch_pos == consumer_batch->count)) {
+            // hand the finished batch back to the decoder and wait for the next one
+            uint64_t head = ring_head.load(std::memory_order_relaxed);
+            if (consumer_batch)
+                ring_head.store(++head, std::memory_order_release);
+
+            while (ring_tail.load(std::memory_order_acquire) == head) {
+                if (threaded)
+                    std::this_thread::yield();
+                else
+                    produce_batch();
+            }
+
+            consumer_batch = &ring[head & (TRACE_RING_SIZE-1)];
+            batch_pos = 0;
+        }
+
+        *rewound = consumer_batch->rewound[batch_pos];
+        return &consumer_batch->entry[batch_pos++];
+    };
+
+  private:
+    TRACE_BATCH *ring;
+    std::atomic<uint64_t> ring_head, ring_tail;
+    std::atomic<uint8_t> stop_requested;
+    std::thread producer;
+    uint8_t threaded; // decode on the simulator thread when the host has a single hardware thread
+
+    // consumer side
+    TRACE_BATCH *consumer_batch;
+    uint32_t batch_pos;
+
+    // producer side
+    input_instr previous_instr;
+    derived_instr previous_derived;
+    uint64_t num_decoded;
+    uint8_t pending_rewind;
+
+    void run();
+    uint8_t produce_batch();
+    void fill_batch(TRACE_BATCH *batch);
+};
+
+// convert one trace record, next is the record that follows current in the trace and provides the branch target
+void decode_input_instr(const input_instr *current, const input_instr *next, ooo_model_instr *arch_instr);
+void decode_cloudsuite_instr(const cloudsuite_instr *current, ooo_model_instr *arch_instr);
+
+// same as decode_input_instr, with the derived fields taken from the derived cache
+void apply_derived_instr(const input_instr *current, const derived_instr *derived, ooo_model_instr *arch_instr);
+void derive_instr(const ooo_model_instr *arch_instr, derived_instr *derived);
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+#include "champsim.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <zlib.h>
+#include <lzma.h>
+#include "chunked_trace.h"
+#include "columnar_trace.h"
+
+#define TRACE_INPUT_BUFFER_SIZE (1<<20)  // compressed bytes pulled from the file at a time
+#define TRACE_OUTPUT_BUFFER_SIZE (1<<22) // decompressed bytes produced per refill
+#define TRACE_MMAP_WINDOW (1<<24)        // bytes of a mapped trace exposed (and read ahead) per refill
+#define SHARED_TRACE_MAX_CHUNKS 32      // chunks a shared trace keeps for lagging readers, TRACE_OUTPUT_BUFFER_SIZE each
+#define SWEEP_RING_SLOTS 8                // chunks of a sweep ring in flight, power of 2
+#define SWEEP_MAX_CONFIGS 64
+
+using namespace std;
+
+// streaming trace reader
+// decompresses the trace in-process into a large buffer and hands out fixed-size records from it
+class TRACE_READER {
+  public:
+    string trace_string;
+    uint32_t format_record_size; // record size stored in the trace, 0 when the format does not record it
+
+    // v2 = 0 for readers that do not read the trace file themselves
+    TRACE_READER(string v1, uint8_t v2 = 1);
+    virtual ~TRACE_READER();
+
+    // point at the next record without copying it, returns NULL at the end of the trace
+    // the record stays valid until the next call
+    const void *next_record(uint32_t record_size) {
+        if ((out_tail - out_head) < record_size) {
+            if (refill() < record_size)
+                return NULL;
+        }
+
+        const void *record = out_buffer + out_head;
+        out_head += record_size;
+
+        return record;
+    };
+
+    // copy the next record into dest, returns 0 at the end of the trace
+    uint8_t read_record(void *dest, uint32_t record_size) {
+        const void *record = next_record(record_size);
+        if (record == NULL)
+            return 0;
+
+        memcpy(dest, record, record_size);
+        return 1;
+    };
+
+    // go back to the first record without spawning any process
+    virtual void rewind();
+
+    // position the reader so that the next record returned is the given record of the trace
+    // returns 0 if the trace is shorter than that
+    virtual uint8_t seek(uint64_t record, uint32_t record_size);
+
+  protected:
+    FILE *file;
+    uint8_t is_pipe,
+            input_done;
+    uint8_t *in_buffer;
+    uint64_t input_pos,   // file offset of the next compressed byte
+             input_begin, // compressed data lives in [input_begin, input_end)
+             input_end;
+
+    // decompress up to size bytes into dest, returns the number of bytes produced (0 at the end of the trace)
+    virtual uint64_t decode(uint8_t *dest, uint64_t size) = 0;
+    virtual void reset_decoder() = 0;
+
+    // read the next block of compressed input, returns the number of bytes read
+    uint64_t read_input();
+
+    // drop buffered output and restart decoding at the given file offset
+    void restart_input(uint64_t offset);
+
+    // throw away the next num_records records
+    uint64_t discard_records(uint64_t num_records, uint32_t record_size);
+
+    uint8_t *out_buffer;
+    uint64_t out_head, out_tail; // records are handed out from [out_head, out_tail)
+
+    // make more records available, returns the number of buffered bytes
+    virtual uint64_t refill();
+
+  private:
+    void open_file();
+};
+
+class GZIP_TRACE_READER : public TRACE_READER {
+  public:
+    GZIP_TRACE_READER(string v1);
+    ~GZIP_TRACE_READER();
+
+  protected:
+    z_stream strm;
+
+    uint64_t decode(uint8_t *dest, uint64_t size);
+    void reset_decoder();
+};
+
+class XZ_TRACE_READER : public TRACE_READER {
+  public:
+    XZ_TRACE_READER(string v1);
+    ~XZ_TRACE_READER();
+
+  protected:
+    lzma_stream strm;
+
+    uint64_t decode(uint8_t *dest, uint64_t size);
+    void reset_decoder();
+};
+
+// seekable chunked container (chunked_trace.h), every chunk is an independent xz stream
+class CHUNKED_TRACE_READER : public XZ_TRACE_READER {
+  public:
+    chunked_trace_header header;
+    vector <chunked_trace_index_entry> index;
+
+    CHUNKED_TRACE_READER(string v1);
+
+    uint8_t seek(uint64_t record, uint32_t record_size);
+};
+
+// chunked container with delta-encoded columnar chunks (columnar_trace.h)
+// a whole chunk is decompressed and decoded back into input_instr records at a time
+class COLUMNAR_TRACE_READER : public TRACE_READER {
+  public:
+    chunked_trace_header header;
+    vector <chunked_trace_index_entry> index;
+
+    COLUMNAR_TRACE_READER(string v1);
+    ~COLUMNAR_TRACE_READER();
+
+    uint8_t seek(uint64_t record, uint32_t record_size);
+
+  protected:
+    COLUMNAR_TRACE_CODEC *codec;
+    input_instr *records;
+    uint8_t *compressed, *encoded;
+    uint64_t compressed_size, encoded_size,
+             next_chunk;
+
+    uint64_t decode(uint8_t *dest, uint64_t size) { return 0; };
+    void reset_decoder() { next_chunk = 0; };
+    uint64_t refill();
+};
+
+// uncompressed trace mapped into memory
+// records are handed out straight from the mapping, rewinding and seeking only move out_head
+class MMAP_TRACE_READER : public TRACE_READER {
+  public:
+    MMAP_TRACE_READER(string v1);
+    ~MMAP_TRACE_READER();
+
+    uint8_t seek(uint64_t record, uint32_t record_size);
+
+  protected:
+    uint8_t *mapping;
+    uint64_t mapping_size;
+
+    uint64_t decode(uint8_t *dest, uint64_t size) { return 0; };
+    void reset_decoder() {};
+    uint64_t refill();
+};
+
+// decompressed records shared by every core that runs the same trace
+class TRACE_CHUNK {
+  public:
+    vector <uint8_t> data;
+    uint8_t end_of_trace;  // marks the wrap-around, holds no records
+    uint32_t readers_left; // readers that have not picked up the chunk yet
+    uint64_t next_record;  // trace record that follows the chunk
+
+    // the next records of reader, rewinds it at the end of the trace
+    static shared_ptr <TRACE_CHUNK> read(TRACE_READER *reader, uint32_t record_size, uint64_t first_record);
+};
+
+// decompresses a trace once for several readers
+// chunks are kept until every reader has picked them up, each reader then holds on to its current chunk on its own.
+// at most SHARED_TRACE_MAX_CHUNKS are kept, a reader that falls further behind goes on with a reader of its own
+class SHARED_TRACE_SOURCE {
+  public:
+    TRACE_READER *reader;
+    uint32_t record_size,
+             num_readers;
+    uint64_t first_record; // trace record the reader was positioned at
+
+    SHARED_TRACE_SOURCE(TRACE_READER *v1, uint32_t v2, uint32_t v3, uint64_t v4);
+    ~SHARED_TRACE_SOURCE();
+
+    // chunk number seq of the stream, decompressed by whichever reader asks for it first
+    // NULL when the chunk was dropped before the reader got to it
+    shared_ptr <TRACE_CHUNK> get_chunk(uint64_t seq);
+
+    // a reader that was left behind stops counting towards the chunks still cached
+    void detach();
+
+  private:
+    std::mutex chunk_lock; // readers may run on different decoder threads
+    deque <shared_ptr <TRACE_CHUNK> > chunks;
+    uint64_t first_chunk,  // sequence number of chunks.front()
+             last_record;  // trace record after the chunks dropped so far
+
+    void drop_used_chunks();
+};
+
+// per-core cursor over a shared trace
+class SHARED_TRACE_READER : public TRACE_READER {
+  public:
+    SHARED_TRACE_READER(shared_ptr <SHARED_TRACE_SOURCE> v1);
+    ~SHARED_TRACE_READER();
+
+    void rewind();
+    uint8_t seek(uint64_t record, uint32_t record_size);
+
+  protected:
+    shared_ptr <SHARED_TRACE_SOURCE> source;
+    shared_ptr <TRACE_CHUNK> current_chunk;
+    TRACE_READER *private_reader; // once the reader fell out of the shared window
+    uint64_t next_chunk,
+             next_record;
+    uint8_t at_end;
+
+    uint64_t decode(uint8_t *dest, uint64_t size) { return 0; };
+    void reset_decoder() {};
+    uint64_t refill();
+};
+
+// decompressed records of one trace handed from the sweep parent to every configuration (-sweep) of a sweep
+// the ring lives in memory shared with the forked configurations, the parent fills a slot once every
+// configuration is done with the chunk it held, a configuration that exits no longer holds any
+class SWEEP_TRACE_RING {
+  public:
+    uint32_t record_size,
+             num_readers;
+    std::atomic<uint64_t> produced,                    // chunks filled so far
+                          consumed[SWEEP_MAX_CONFIGS]; // chunks every configuration is done with
+    std::atomic<uint8_t> stop_requested;
+
+    // maps a ring shared by the processes forked after it
+    static SWEEP_TRACE_RING *create(uint32_t record_size, uint32_t num_readers);
+
+    // parent side, decompresses the trace into the ring until stop() and rewinds it at its end
+    void produce(TRACE_READER *reader);
+    void stop() { stop_requested.store(1); };
+
+    uint64_t slot_size(uint64_t seq) { return slots[seq & (SWEEP_RING_SLOTS-1)].size; };
+    uint8_t slot_end_of_trace(uint64_t seq) { return slots[seq & (SWEEP_RING_SLOTS-1)].end_of_trace; };
+    uint8_t *slot_data(uint64_t seq) { return data + (seq & (SWEEP_RING_SLOTS-1)) * TRACE_OUTPUT_BUFFER_SIZE; };
+
+  private:
+    struct {
+        uint64_t size;
+        uint8_t end_of_trace; // marks the wrap-around, holds no records
+    } slots[SWEEP_RING_SLOTS];
+    uint8_t *data;
+};
+
+// a configuration's cursor over a sweep ring
+class SWEEP_TRACE_READER : public TRACE_READER {
+  public:
+    SWEEP_TRACE_READER(SWEEP_TRACE_RING *v1, uint32_t v2, string v3);
+    ~SWEEP_TRACE_READER();
+
+    void rewind();
+    uint8_t seek(uint64_t record, uint32_t record_size);
+
+  protected:
+    SWEEP_TRACE_RING *ring;
+    uint32_t config;
+    uint64_t next_chunk;
+    uint8_t at_end;
+
+    uint64_t decode(uint8_t *dest, uint64_t size) { return 0; };
+    void reset_decoder() {};
+    uint64_t refill();
+};
+
+// picks the decoder from the file extension, returns NULL for unsupported formats
+TRACE_READER *open_trace_reader(const char *trace_string);
+
+#endif
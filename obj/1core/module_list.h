@@ -0,0 +1,13 @@
+// generated by the Makefile
+#define BRANCH_PREDICTORS(f) f(bimodal) f(gshare) f(hashed_perceptron) f(perceptron)
+#define L1I_PREFETCHERS(f) f(next_line) f(no)
+#define L1D_PREFETCHERS(f) f(next_line) f(no)
+#define L2C_PREFETCHERS(f) f(ip_stride) f(kpcp) f(next_line) f(no) f(spp_dev)
+#define LLC_PREFETCHERS(f) f(next_line) f(no)
+#define LLC_REPLACEMENTS(f) f(drrip) f(lru) f(ship) f(srrip)
+#define DEFAULT_BRANCH_PREDICTOR "bimodal"
+#define DEFAULT_L1I_PREFETCHER "no"
+#define DEFAULT_L1D_PREFETCHER "no"
+#define DEFAULT_L2C_PREFETCHER "no"
+#define DEFAULT_LLC_PREFETCHER "no"
+#define DEFAULT_LLC_REPLACEMENT "lru"
@@ -59,12 +59,7 @@ uint32_t CACHE::lru_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const
 void CACHE::lru_update(uint32_t set, uint32_t way)
 {
     // update lru replacement state
-    for (uint32_t i=0; i<NUM_WAY; i++) {
-        if (block[set][i].lru < block[set][way].lru) {
-            block[set][i].lru++;
-        }
-    }
-    block[set][way].lru = 0; // promote to the MRU position
+    lru_update_set(block[set], way);
 }
 
 void CACHE::replacement_final_stats()
@@ -0,0 +1,88 @@
+#!/bin/bash
+
+# Simulator throughput benchmark, run from the ChampSim directory (make benchmark)
+# builds single-core and 4-core binaries, generates the synthetic traces once (scripts/synthetic_trace.cc)
+# and appends one CSV row per scenario to OUTPUT with the host KIPS, simulated cycles per second and peak RSS
+
+if [ "$#" -gt 3 ]; then
+    echo "Illegal number of parameters"
+    echo "Usage: ./scripts/benchmark.sh [OUTPUT] [N_WARM] [N_SIM]"
+    exit 1
+fi
+
+OUTPUT=${1:-benchmark.csv}
+N_WARM=${2:-500000}     # instructions per core
+N_SIM=${3:-2000000}     # instructions per core
+TRACE_DIR=$PWD/benchmark_traces
+RESULT_DIR=$PWD/benchmark_results
+BINARY_1CORE=bimodal-no-no-no-no-lru-1core
+BINARY_4CORE=bimodal-no-no-no-no-lru-4core
+
+re='^[0-9]+$'
+if ! [[ $N_WARM =~ $re ]] || ! [[ $N_SIM =~ $re ]] ; then
+    echo "[ERROR]: Number of warmup or simulation instructions is NOT a number" >&2;
+    exit 1
+fi
+
+if [ ! -f ./build_champsim.sh ] ; then
+    echo "[ERROR] Run the benchmark from the ChampSim directory"
+    exit 1
+fi
+
+# Build
+for NUM_CORE in 1 4; do
+    ./build_champsim.sh bimodal no no no no lru ${NUM_CORE} > /dev/null || exit 1
+done
+if [ ! -f bin/${BINARY_1CORE} ] || [ ! -f bin/${BINARY_4CORE} ] ; then
+    echo "[ERROR] ChampSim build FAILED"
+    exit 1
+fi
+
+mkdir -p bin
+g++ -O3 -std=c++11 -Iinc scripts/synthetic_trace.cc -o bin/synthetic_trace -lz || exit 1
+
+# Traces, regenerated only when the length changes
+N_TRACE=$((N_WARM + N_SIM))
+mkdir -p ${TRACE_DIR} ${RESULT_DIR}
+for KIND in stream pointer_chase branch store; do
+    TRACE=${TRACE_DIR}/${KIND}-${N_TRACE}.champsimtrace.gz
+    if [ ! -f ${TRACE} ] ; then
+        ./bin/synthetic_trace ${KIND} ${N_TRACE} ${TRACE} || exit 1
+    fi
+done
+
+if [ ! -f ${OUTPUT} ] ; then
+    echo "revision,scenario,cores,instructions,cycles,seconds,kips,cycles_per_second,peak_rss_kb" > ${OUTPUT}
+fi
+REVISION=$(git rev-parse --short HEAD 2> /dev/null || echo unknown)
+
+# usage: run_scenario NAME BINARY CORES TRACE...
+run_scenario() {
+    NAME=$1
+    BINARY=$2
+    CORES=$3
+    shift 3
+    LOG=${RESULT_DIR}/${NAME}.txt
+
+    echo "Running ${NAME}..."
+    ./bin/${BINARY} -warmup_instructions ${N_WARM} -simulation_instructions ${N_SIM} -hide_heartbeat -host_stats -traces "$@" &> ${LOG}
+
+    # Host seconds: S instructions: I cycles: C KIPS: K cycles/s: R peak RSS KB: M
+    STATS=$(grep "^Host seconds:" ${LOG})
+    if [ -z "$STATS" ] ; then
+        echo "[ERROR] ${NAME} did not complete, see ${LOG}"
+        exit 1
+    fi
+    echo "$STATS" | awk -v revision=${REVISION} -v name=${NAME} -v cores=${CORES} \
+        '{ print revision "," name "," cores "," $5 "," $7 "," $3 "," $9 "," $11 "," $15 }' >> ${OUTPUT}
+    echo "$STATS"
+}
+
+run_scenario stream ${BINARY_1CORE} 1 ${TRACE_DIR}/stream-${N_TRACE}.champsimtrace.gz
+run_scenario pointer_chase ${BINARY_1CORE} 1 ${TRACE_DIR}/pointer_chase-${N_TRACE}.champsimtrace.gz
+run_scenario branch ${BINARY_1CORE} 1 ${TRACE_DIR}/branch-${N_TRACE}.champsimtrace.gz
+run_scenario store ${BINARY_1CORE} 1 ${TRACE_DIR}/store-${N_TRACE}.champsimtrace.gz
+run_scenario mix ${BINARY_4CORE} 4 ${TRACE_DIR}/stream-${N_TRACE}.champsimtrace.gz ${TRACE_DIR}/pointer_chase-${N_TRACE}.champsimtrace.gz \
+    ${TRACE_DIR}/branch-${N_TRACE}.champsimtrace.gz ${TRACE_DIR}/store-${N_TRACE}.champsimtrace.gz
+
+echo "Results: ${OUTPUT}"
@@ -0,0 +1,67 @@
+// builds the derived cache sidecar of a ChampSim trace (TRACE.derived.raw)
+// every entry holds the branch classification, branch target and operand counts the simulator derives from a record,
+// runs with -derived_cache then read them instead of classifying every instruction again
+//
+// build: g++ -O3 -std=c++11 -pthread -I../inc build_derived_cache.cc ../src/tracedecoder.cc ../src/tracereader.cc -o build_derived_cache -lz -llzma
+// usage: ./build_derived_cache TRACE
+
+#include "tracedecoder.h"
+
+uint8_t MAX_INSTR_DESTINATIONS = NUM_INSTR_DESTINATIONS,
+        knob_cloudsuite = 0;
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        cerr << "usage: " << argv[0] << " TRACE" << endl;
+        return 1;
+    }
+
+    TRACE_READER *reader = open_trace_reader(argv[1]);
+    if (reader == NULL) {
+        cerr << "unsupported input trace: " << argv[1] << endl;
+        return 1;
+    }
+
+    string output_name = string(argv[1]) + ".derived.raw";
+    FILE *output = fopen(output_name.c_str(), "wb");
+    if (output == NULL) {
+        cerr << "cannot open output: " << output_name << endl;
+        return 1;
+    }
+
+    // the branch target of a record comes from the one after it, and the last record wraps around to the first
+    input_instr first_instr, current_instr;
+    const input_instr *next;
+    uint64_t num_records = 0;
+
+    while ((next = (const input_instr *)reader->next_record(sizeof(input_instr))) != NULL) {
+        if (num_records == 0)
+            first_instr = *next;
+        else {
+            ooo_model_instr arch_instr;
+            derived_instr derived;
+            decode_input_instr(&current_instr, next, &arch_instr);
+            derive_instr(&arch_instr, &derived);
+            fwrite(&derived, sizeof(derived), 1, output);
+        }
+
+        current_instr = *next;
+        num_records++;
+    }
+
+    if (num_records) {
+        ooo_model_instr arch_instr;
+        derived_instr derived;
+        decode_input_instr(&current_instr, &first_instr, &arch_instr);
+        derive_instr(&arch_instr, &derived);
+        fwrite(&derived, sizeof(derived), 1, output);
+    }
+
+    fclose(output);
+    delete reader;
+
+    cout << output_name << ": " << num_records << " entries" << endl;
+
+    return 0;
+}
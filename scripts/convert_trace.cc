@@ -0,0 +1,118 @@
+// converts a ChampSim trace into the seekable chunked container (.cct)
+// -columnar stores every chunk with the delta-encoded columnar codec (columnar_trace.h) instead of raw records
+//
+// build: g++ -O3 -std=c++11 -pthread -I../inc convert_trace.cc ../src/tracereader.cc -o convert_trace -lz -llzma
+// usage: ./convert_trace [-cloudsuite] [-columnar] [-chunk_records N] [-threads N] INPUT_TRACE OUTPUT.cct
+
+#include <thread>
+#include "tracereader.h"
+#include "instruction.h"
+
+int main(int argc, char** argv)
+{
+    uint32_t record_size = sizeof(input_instr),
+             chunk_records = 0,
+             num_threads = std::thread::hardware_concurrency();
+    uint8_t columnar = 0;
+    int i;
+
+    for (i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-cloudsuite") == 0)
+            record_size = sizeof(cloudsuite_instr);
+        else if (strcmp(argv[i], "-columnar") == 0)
+            columnar = 1;
+        else if ((strcmp(argv[i], "-chunk_records") == 0) && (i+1 < argc))
+            chunk_records = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "-threads") == 0) && (i+1 < argc))
+            num_threads = atoi(argv[++i]);
+        else
+            break;
+    }
+
+    if (chunk_records == 0)
+        chunk_records = columnar ? COLUMNAR_TRACE_RECORDS_PER_CHUNK : CHUNKED_TRACE_RECORDS_PER_CHUNK;
+
+    if ((argc - i) != 2) {
+        cerr << "usage: " << argv[0] << " [-cloudsuite] [-columnar] [-chunk_records N] [-threads N] INPUT_TRACE OUTPUT.cct" << endl;
+        return 1;
+    }
+    if (columnar && (record_size != sizeof(input_instr))) {
+        cerr << "the columnar codec only supports input_instr traces" << endl;
+        return 1;
+    }
+    if (num_threads == 0)
+        num_threads = 1;
+
+    TRACE_READER *reader = open_trace_reader(argv[i]);
+    if (reader == NULL) {
+        cerr << "unsupported input trace: " << argv[i] << endl;
+        return 1;
+    }
+
+    FILE *output = fopen(argv[i+1], "wb");
+    if (output == NULL) {
+        cerr << "cannot open output: " << argv[i+1] << endl;
+        return 1;
+    }
+
+    CHUNKED_TRACE_WRITER writer(output, record_size, chunk_records, CHUNKED_TRACE_PRESET, columnar ? CHUNKED_TRACE_COLUMNAR_MAGIC : CHUNKED_TRACE_MAGIC);
+
+    // fill one chunk per thread, encode and compress them in parallel and append them in trace order
+    size_t chunk_size = (size_t)record_size * chunk_records,
+           encoded_bound = columnar ? COLUMNAR_TRACE_CODEC::encoded_bound(chunk_records) : chunk_size,
+           bound = lzma_stream_buffer_bound(encoded_bound);
+    vector <uint8_t*> raw(num_threads), encoded(num_threads), compressed(num_threads);
+    vector <size_t> raw_size(num_threads), compressed_size(num_threads);
+    vector <COLUMNAR_TRACE_CODEC*> codec(num_threads);
+    for (uint32_t t=0; t<num_threads; t++) {
+        raw[t] = new uint8_t[chunk_size];
+        encoded[t] = columnar ? new uint8_t[encoded_bound] : NULL;
+        compressed[t] = new uint8_t[bound];
+        codec[t] = columnar ? new COLUMNAR_TRACE_CODEC(chunk_records) : NULL;
+    }
+
+    uint8_t end_of_trace = 0;
+    while (!end_of_trace) {
+        uint32_t num_chunks = 0;
+        for (uint32_t t=0; t<num_threads && !end_of_trace; t++) {
+            raw_size[t] = 0;
+            while ((raw_size[t] < chunk_size) && reader->read_record(raw[t] + raw_size[t], record_size))
+                raw_size[t] += record_size;
+
+            if (raw_size[t] < chunk_size)
+                end_of_trace = 1;
+            if (raw_size[t])
+                num_chunks++;
+        }
+
+        vector <std::thread> workers;
+        for (uint32_t t=0; t<num_chunks; t++)
+            workers.push_back(std::thread([&, t]() {
+                if (columnar) {
+                    size_t encoded_size = codec[t]->encode((input_instr *)raw[t], raw_size[t] / record_size, encoded[t]);
+                    compressed_size[t] = CHUNKED_TRACE_WRITER::compress_chunk(encoded[t], encoded_size, compressed[t], bound, CHUNKED_TRACE_PRESET);
+                }
+                else
+                    compressed_size[t] = CHUNKED_TRACE_WRITER::compress_chunk(raw[t], raw_size[t], compressed[t], bound, CHUNKED_TRACE_PRESET);
+            }));
+        for (uint32_t t=0; t<num_chunks; t++) {
+            workers[t].join();
+            writer.append_chunk(compressed[t], compressed_size[t], raw_size[t] / record_size);
+        }
+    }
+
+    writer.finish();
+    fclose(output);
+
+    cout << argv[i+1] << ": " << writer.header.num_records << " records in " << writer.header.num_chunks << " chunks" << endl;
+
+    for (uint32_t t=0; t<num_threads; t++) {
+        delete[] raw[t];
+        delete[] encoded[t];
+        delete[] compressed[t];
+        delete codec[t];
+    }
+    delete reader;
+
+    return 0;
+}
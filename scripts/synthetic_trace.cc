@@ -0,0 +1,236 @@
+// writes a synthetic ChampSim trace (gzip) that stresses one part of the simulator, used by scripts/benchmark.sh
+//   stream:        sequential loads over a 64 MB array, a new cache line every 8 loads
+//   pointer_chase: every load depends on the previous one and lands on a random line of a 256 MB footprint, 14 instructions apart
+//   branch:        short blocks ending in conditional branches, biased, patterned or random
+//   store:         sequential stores over a 64 MB array plus a random store into 16 MB every 8 stores
+// the same kind, count and seed always give the same trace
+//
+// build: g++ -O3 -std=c++11 -I../inc synthetic_trace.cc -o synthetic_trace -lz
+// usage: ./synthetic_trace KIND INSTRUCTIONS OUTPUT.champsimtrace.gz [SEED]
+
+#include <zlib.h>
+#include "champsim.h"
+#include "instruction.h"
+
+#define CODE_BASE 0x400000
+#define STREAM_BASE 0x10000000
+#define STREAM_SIZE (64ULL << 20)
+#define CHASE_BASE 0x40000000
+#define CHASE_SIZE (256ULL << 20)
+#define SCATTER_BASE 0x80000000
+#define SCATTER_SIZE (16ULL << 20)
+#define LOOP_ITERATIONS 64
+
+// general purpose registers, away from the ones that mark branches
+#define REG_INDEX 1
+#define REG_POINTER 2
+#define REG_VALUE 3
+#define REG_SUM 4
+#define REG_TEMP 5
+
+class SYNTHETIC_TRACE {
+  public:
+    uint64_t ip, written, limit, state;
+    gzFile output;
+
+    SYNTHETIC_TRACE(gzFile v1, uint64_t v2, uint64_t v3) : ip(CODE_BASE), written(0), limit(v2), state(v3 ? v3 : 1), output(v1) {};
+
+    uint8_t done() { return written >= limit; };
+
+    // xorshift64
+    uint64_t random() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+
+    void emit(input_instr &instr) {
+        if (done())
+            return;
+        instr.ip = ip;
+        if (gzwrite(output, &instr, sizeof(instr)) != (int)sizeof(instr)) {
+            cerr << "cannot write the trace" << endl;
+            exit(1);
+        }
+        written++;
+        ip += 4;
+    };
+
+    void alu(uint8_t dst, uint8_t src1, uint8_t src2) {
+        input_instr instr;
+        instr.destination_registers[0] = dst;
+        instr.source_registers[0] = src1;
+        instr.source_registers[1] = src2;
+        emit(instr);
+    };
+
+    void load(uint8_t dst, uint8_t addr_reg, uint64_t addr) {
+        input_instr instr;
+        instr.destination_registers[0] = dst;
+        instr.source_registers[0] = addr_reg;
+        instr.source_memory[0] = addr;
+        emit(instr);
+    };
+
+    void store(uint8_t src, uint8_t addr_reg, uint64_t addr) {
+        input_instr instr;
+        instr.source_registers[0] = src;
+        instr.source_registers[1] = addr_reg;
+        instr.destination_memory[0] = addr;
+        emit(instr);
+    };
+
+    void compare(uint8_t src) {
+        input_instr instr;
+        instr.destination_registers[0] = REG_FLAGS;
+        instr.source_registers[0] = src;
+        emit(instr);
+    };
+
+    // the tracer decodes a conditional branch from reading ip and flags and writing ip
+    void branch(uint8_t taken, uint64_t target) {
+        input_instr instr;
+        instr.is_branch = 1;
+        instr.branch_taken = taken;
+        instr.destination_registers[0] = REG_INSTRUCTION_POINTER;
+        instr.source_registers[0] = REG_INSTRUCTION_POINTER;
+        instr.source_registers[1] = REG_FLAGS;
+        uint64_t next_ip = ip + 4;
+        emit(instr);
+        ip = taken ? target : next_ip;
+    };
+
+    void jump(uint64_t target) {
+        input_instr instr;
+        instr.is_branch = 1;
+        instr.branch_taken = 1;
+        instr.destination_registers[0] = REG_INSTRUCTION_POINTER;
+        emit(instr);
+        ip = target;
+    };
+
+    // closes a loop body starting at head, taken back except on the last iteration
+    void loop_end(uint64_t head, uint64_t iteration) {
+        alu(REG_INDEX, REG_INDEX, 0);
+        compare(REG_INDEX);
+        if ((iteration % LOOP_ITERATIONS) == LOOP_ITERATIONS-1) {
+            branch(0, head);
+            jump(head);
+        }
+        else
+            branch(1, head);
+    };
+};
+
+void write_stream(SYNTHETIC_TRACE &trace)
+{
+    uint64_t head = trace.ip, offset = 0;
+    for (uint64_t i=0; !trace.done(); i++) {
+        for (int j=0; j<4; j++) {
+            trace.load(REG_VALUE, REG_INDEX, STREAM_BASE + offset);
+            trace.alu(REG_SUM, REG_SUM, REG_VALUE);
+            offset = (offset + 8) % STREAM_SIZE;
+        }
+        trace.loop_end(head, i);
+    }
+}
+
+void write_pointer_chase(SYNTHETIC_TRACE &trace)
+{
+    uint64_t head = trace.ip;
+    for (uint64_t i=0; !trace.done(); i++) {
+        uint64_t next = CHASE_BASE + ((trace.random() % CHASE_SIZE) & ~(uint64_t)(BLOCK_SIZE-1));
+        trace.load(REG_POINTER, REG_POINTER, next);
+        trace.load(REG_VALUE, REG_POINTER, next + 8);
+        trace.alu(REG_SUM, REG_SUM, REG_VALUE);
+        // independent work the core can overlap with the miss
+        for (int j=0; j<4; j++) {
+            trace.alu(REG_INDEX, REG_INDEX, 0);
+            trace.alu(REG_TEMP, REG_TEMP, REG_INDEX);
+        }
+        trace.loop_end(head, i);
+    }
+}
+
+void write_branch(SYNTHETIC_TRACE &trace)
+{
+    uint64_t head = trace.ip, offset = 0;
+    for (uint64_t i=0; !trace.done(); i++) {
+        // 16 blocks per iteration, each skips its two last instructions when its branch is taken
+        for (int j=0; j<16; j++) {
+            uint8_t taken;
+            switch (j % 4) {
+                case 0: taken = (trace.random() % 100) < 90; break; // biased
+                case 1: taken = (i + j) & 1; break; // alternating
+                case 2: taken = (i % 3) == 0; break; // period 3
+                default: taken = trace.random() & 1; break; // random
+            }
+            trace.load(REG_VALUE, REG_INDEX, STREAM_BASE + offset);
+            offset = (offset + 8) % (64 << 10);
+            trace.compare(REG_VALUE);
+            uint64_t skip = trace.ip + 12;
+            trace.branch(taken, skip);
+            if (!taken) {
+                trace.alu(REG_SUM, REG_SUM, REG_VALUE);
+                trace.alu(REG_VALUE, REG_SUM, 0);
+            }
+        }
+        trace.loop_end(head, i);
+    }
+}
+
+void write_store(SYNTHETIC_TRACE &trace)
+{
+    uint64_t head = trace.ip, offset = 0;
+    for (uint64_t i=0; !trace.done(); i++) {
+        for (int j=0; j<8; j++) {
+            trace.store(REG_VALUE, REG_INDEX, STREAM_BASE + offset);
+            offset = (offset + 8) % STREAM_SIZE;
+        }
+        trace.store(REG_VALUE, REG_POINTER, SCATTER_BASE + ((trace.random() % SCATTER_SIZE) & ~(uint64_t)7));
+        trace.load(REG_VALUE, REG_INDEX, STREAM_BASE + offset);
+        trace.loop_end(head, i);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc != 4) && (argc != 5)) {
+        cerr << "usage: " << argv[0] << " stream|pointer_chase|branch|store INSTRUCTIONS OUTPUT.champsimtrace.gz [SEED]" << endl;
+        return 1;
+    }
+
+    string kind = argv[1];
+    uint64_t instructions = strtoull(argv[2], NULL, 10),
+             seed = (argc == 5) ? strtoull(argv[4], NULL, 10) : 1;
+    if ((kind != "stream") && (kind != "pointer_chase") && (kind != "branch") && (kind != "store")) {
+        cerr << "unknown kind: " << kind << endl;
+        return 1;
+    }
+
+    gzFile output = gzopen(argv[3], "wb");
+    if (output == NULL) {
+        cerr << "cannot open output: " << argv[3] << endl;
+        return 1;
+    }
+
+    SYNTHETIC_TRACE trace(output, instructions, seed);
+    if (kind == "stream")
+        write_stream(trace);
+    else if (kind == "pointer_chase")
+        write_pointer_chase(trace);
+    else if (kind == "branch")
+        write_branch(trace);
+    else
+        write_store(trace);
+
+    if (gzclose(output) != Z_OK) {
+        cerr << "cannot write output: " << argv[3] << endl;
+        return 1;
+    }
+
+    cout << argv[3] << ": " << trace.written << " instructions" << endl;
+
+    return 0;
+}
@@ -106,6 +106,9 @@ void PACKET_QUEUE::remove_queue(PACKET *packet)
     cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec << " fill_level: " << packet->fill_level;
     cout << " head: " << head << " tail: " << tail << " occupancy: " << occupancy << " event_cycle: " << packet->event_cycle << endl; });
 
+    if (slots)
+        slots->release(packet - entry);
+
     // reset entry
     PACKET empty_packet;
     *packet = empty_packet;
@@ -115,3 +118,95 @@ void PACKET_QUEUE::remove_queue(PACKET *packet)
     if (head >= SIZE)
         head = 0;
 }
+
+QUEUE_SLOTS::QUEUE_SLOTS(uint32_t v1) : SIZE(v1)
+{
+    num_words = (SIZE + 63) / 64;
+    free_bits = new uint64_t[num_words];
+    for (uint32_t i=0; i<num_words; i++)
+        free_bits[i] = ((i+1)*64 <= SIZE) ? UINT64_MAX : ((1ULL << (SIZE % 64)) - 1);
+
+    bucket_bits = 1;
+    while ((1u << bucket_bits) < SIZE)
+        bucket_bits++;
+    bucket = new uint32_t[1 << bucket_bits];
+    for (uint32_t i=0; i<(1u << bucket_bits); i++)
+        bucket[i] = SIZE;
+
+    slot_address = new uint64_t[SIZE];
+    next = new uint32_t[SIZE];
+    for (uint32_t i=0; i<SIZE; i++) {
+        slot_address[i] = 0;
+        next[i] = SIZE;
+    }
+}
+
+QUEUE_SLOTS::~QUEUE_SLOTS()
+{
+    delete[] free_bits;
+    delete[] bucket;
+    delete[] slot_address;
+    delete[] next;
+}
+
+uint32_t QUEUE_SLOTS::allocate(uint64_t address)
+{
+    for (uint32_t i=0; i<num_words; i++) {
+        if (free_bits[i] == 0)
+            continue;
+
+        uint32_t slot = i*64 + __builtin_ctzll(free_bits[i]);
+        free_bits[i] &= free_bits[i] - 1;
+
+        slot_address[slot] = address;
+        next[slot] = bucket[hash(address)];
+        bucket[hash(address)] = slot;
+
+        return slot;
+    }
+
+    return SIZE;
+}
+
+void QUEUE_SLOTS::release(uint32_t slot)
+{
+    uint32_t *link = &bucket[hash(slot_address[slot])];
+    while (*link != slot) {
+        if (*link == SIZE) {
+            cerr << "[QUEUE_SLOTS] " << __func__ << " slot: " << slot << " is not in use" << endl;
+            assert(0);
+        }
+        link = &next[*link];
+    }
+    *link = next[slot];
+
+    next[slot] = SIZE;
+    slot_address[slot] = 0;
+    free_bits[slot / 64] |= 1ULL << (slot % 64);
+}
+
+uint32_t QUEUE_SLOTS::find(uint64_t address)
+{
+    uint32_t found = SIZE;
+    for (uint32_t slot = bucket[hash(address)]; slot != SIZE; slot = next[slot]) {
+        if ((slot_address[slot] == address) && (slot < found))
+            found = slot;
+    }
+
+    return found;
+}
+
+uint32_t QUEUE_SLOTS::next_used(uint32_t slot)
+{
+    for (uint32_t i = slot / 64; i < num_words; i++) {
+        uint64_t used = ~free_bits[i];
+        if ((i+1)*64 > SIZE)
+            used &= (1ULL << (SIZE % 64)) - 1;
+        if (i == slot / 64)
+            used &= UINT64_MAX << (slot % 64);
+        if (used)
+            return i*64 + __builtin_ctzll(used);
+    }
+
+    return SIZE;
+}
@@ -1,5 +1,6 @@
 #include "cache.h"
 #include "set.h"
+#include "checkpoint.h"
 
 uint64_t l2pf_access = 0;
 
@@ -1053,19 +1054,33 @@ void CACHE::operate()
         handle_prefetch();
 }
 
+// earliest cycle at which operate() may do anything, nothing changes before it
+uint64_t CACHE::next_operate_cycle()
+{
+    uint64_t next_cycle = UINT64_MAX;
+
+    if (MSHR.next_fill_index < MSHR.SIZE)
+        next_cycle = MSHR.next_fill_cycle;
+    if (WQ.occupancy && (WQ.entry[WQ.head].event_cycle < next_cycle))
+        next_cycle = WQ.entry[WQ.head].event_cycle;
+    if (RQ.occupancy && (RQ.entry[RQ.head].event_cycle < next_cycle))
+        next_cycle = RQ.entry[RQ.head].event_cycle;
+    if (PQ.occupancy && (PQ.entry[PQ.head].event_cycle < next_cycle))
+        next_cycle = PQ.entry[PQ.head].event_cycle;
+
+    return next_cycle;
+}
+
 uint32_t CACHE::get_set(uint64_t address)
 {
-    return (uint32_t) (address & ((1 << lg2(NUM_SET)) - 1)); 
+    return (uint32_t) (address & SET_MASK); 
 }
 
 uint32_t CACHE::get_way(uint64_t address, uint32_t set)
 {
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == address)) 
-            return way;
-    }
+    int way = find_way(block[set], address);
 
-    return NUM_WAY;
+    return (way < 0) ? NUM_WAY : way;
 }
 
 void CACHE::fill_cache(uint32_t set, uint32_t way, PACKET *packet)
@@ -1130,20 +1145,14 @@ int CACHE::check_hit(PACKET *packet)
     }
 
     // hit
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == packet->address)) {
-
-            match_way = way;
+    match_way = find_way(block[set], packet->address);
 
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
-            cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
-            cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
-
-            break;
-        }
-    }
+    DP ( if ((match_way >= 0) && warmup_complete[packet->cpu]) {
+    uint32_t way = match_way;
+    cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
+    cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+    cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
+    cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
 
     return match_way;
 }
@@ -1160,20 +1169,16 @@ int CACHE::invalidate_entry(uint64_t inval_addr)
     }
 
     // invalidate
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == inval_addr)) {
-
-            block[set][way].valid = 0;
+    match_way = find_way(block[set], inval_addr);
+    if (match_way >= 0) {
+        uint32_t way = match_way;
 
-            match_way = way;
+        block[set][way].valid = 0;
 
-            DP ( if (warmup_complete[cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
-            cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
-
-            break;
-        }
+        DP ( if (warmup_complete[cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
+        cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+        cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
     }
 
     return match_way;
@@ -1625,7 +1630,7 @@ void CACHE::update_fill_cycle()
     // update next_fill_cycle
     uint64_t min_cycle = UINT64_MAX;
     uint32_t min_index = MSHR.SIZE;
-    for (uint32_t i=0; i<MSHR.SIZE; i++) {
+    for (uint32_t i=MSHR.slots->next_used(0); i<MSHR.SIZE; i=MSHR.slots->next_used(i+1)) {
         if ((MSHR.entry[i].returned == COMPLETED) && (MSHR.entry[i].event_cycle < min_cycle)) {
             min_cycle = MSHR.entry[i].event_cycle;
             min_index = i;
@@ -1656,24 +1661,22 @@ int CACHE::check_mshr(PACKET *packet)
     // search mshr
   //bool instruction_and_data_collision = false;
   
-  for (uint32_t index=0; index<MSHR_SIZE; index++)
+  uint32_t index = MSHR.slots->find(packet->address);
+  if (index < MSHR_SIZE)
     {
-      if (MSHR.entry[index].address == packet->address)
-	{
-	  //if(MSHR.entry[index].instruction != packet->instruction)
-	  //  {
-	  //    instruction_and_data_collision = true;
-	  //  }
-	  //else
-	  //  {
-	      DP ( if (warmup_complete[packet->cpu]) {
-		  cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
-		  cout << " address: " << hex << packet->address;
-		  cout << " full_addr: " << packet->full_addr << dec << endl; });
-	    
-	      return index;
-	  //  }
-	}
+      //if(MSHR.entry[index].instruction != packet->instruction)
+      //  {
+      //    instruction_and_data_collision = true;
+      //  }
+      //else
+      //  {
+	  DP ( if (warmup_complete[packet->cpu]) {
+	      cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
+	      cout << " address: " << hex << packet->address;
+	      cout << " full_addr: " << packet->full_addr << dec << endl; });
+
+	  return index;
+      //  }
     }
 
     //if(instruction_and_data_collision) // remove instruction-and-data collision safeguard
@@ -1701,22 +1704,19 @@ void CACHE::add_mshr(PACKET *packet)
 
     packet->cycle_enqueued = current_core_cycle[packet->cpu];
 
-    // search mshr
-    for (index=0; index<MSHR_SIZE; index++) {
-        if (MSHR.entry[index].address == 0) {
-            
-            MSHR.entry[index] = *packet;
-            MSHR.entry[index].returned = INFLIGHT;
-            MSHR.occupancy++;
+    // lowest free entry
+    index = MSHR.slots->allocate(packet->address);
+    if (index == MSHR_SIZE)
+        return;
 
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "_MSHR] " << __func__ << " instr_id: " << packet->instr_id;
-            cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec;
-            cout << " index: " << index << " occupancy: " << MSHR.occupancy << endl; });
+    MSHR.entry[index] = *packet;
+    MSHR.entry[index].returned = INFLIGHT;
+    MSHR.occupancy++;
 
-            break;
-        }
-    }
+    DP ( if (warmup_complete[packet->cpu]) {
+    cout << "[" << NAME << "_MSHR] " << __func__ << " instr_id: " << packet->instr_id;
+    cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec;
+    cout << " index: " << index << " occupancy: " << MSHR.occupancy << endl; });
 }
 
 uint32_t CACHE::get_occupancy(uint8_t queue_type, uint64_t address)
@@ -1751,3 +1751,177 @@ void CACHE::increment_WQ_FULL(uint64_t address)
 {
     WQ.FULL++;
 }
+
+// functional warmup (O3_CPU::functional_instruction), a hit or a fill from the levels below happens at once,
+// the prefetchers are trained as in handle_read and handle_prefetch and their prefetches are handled right away
+void CACHE::functional_access(PACKET *packet)
+{
+    uint32_t access_cpu = packet->cpu,
+             set = get_set(packet->address);
+    int way = check_hit(packet);
+    uint8_t train = (packet->type == LOAD) || ((packet->type == PREFETCH) && (packet->pf_origin_level < fill_level));
+
+    if (way >= 0) { // hit
+        if (train)
+            functional_prefetcher_operate(packet, 1, block[set][way].prefetch);
+
+        if ((cache_type == IS_ITLB) || (cache_type == IS_DTLB) || (cache_type == IS_STLB))
+            packet->data = block[set][way].data;
+
+        // update replacement policy
+        if (cache_type == IS_LLC)
+            llc_update_replacement_state(access_cpu, set, way, block[set][way].full_addr, packet->ip, 0, packet->type, 1);
+        else
+            update_replacement_state(access_cpu, set, way, block[set][way].full_addr, packet->ip, 0, packet->type, 1);
+
+        if ((packet->type == WRITEBACK) || ((cache_type == IS_L1D) && (packet->type == RFO)))
+            block[set][way].dirty = 1;
+        else if (packet->type != PREFETCH) {
+            if (block[set][way].prefetch) {
+                pf_useful++;
+                block[set][way].prefetch = 0;
+            }
+            block[set][way].used = 1;
+        }
+    }
+    else { // miss
+        if (train)
+            functional_prefetcher_operate(packet, 0, 0);
+
+        // writebacks allocate without reading the block, the page table ends the TLB chain
+        if (packet->type != WRITEBACK) {
+            if (lower_level)
+                lower_level->functional_access(packet);
+            else if (cache_type == IS_STLB)
+                packet->data = va_to_pa(access_cpu, packet->instr_id, packet->full_addr, packet->address, 0) >> LOG2_PAGE_SIZE;
+        }
+
+        // prefetches for a lower level only pass through
+        if (packet->fill_level <= fill_level) {
+            if (cache_type == IS_LLC)
+                way = llc_find_victim(access_cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+            else
+                way = find_victim(access_cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+
+#ifdef LLC_BYPASS
+            if ((cache_type == IS_LLC) && (way == (int)LLC_WAY)) {
+                llc_update_replacement_state(access_cpu, set, way, packet->full_addr, packet->ip, 0, packet->type, 0);
+                way = -1;
+            }
+#endif
+        }
+
+        if ((packet->fill_level <= fill_level) && (way >= 0)) {
+            // the dirty victim is written back to the level below
+            if (block[set][way].dirty && lower_level) {
+                PACKET writeback_packet;
+
+                writeback_packet.fill_level = fill_level << 1;
+                writeback_packet.cpu = access_cpu;
+                writeback_packet.address = block[set][way].address;
+                writeback_packet.full_addr = block[set][way].full_addr;
+                writeback_packet.data = block[set][way].data;
+                writeback_packet.instr_id = packet->instr_id;
+                writeback_packet.ip = 0;
+                writeback_packet.type = WRITEBACK;
+
+                lower_level->functional_access(&writeback_packet);
+            }
+
+            // update prefetcher
+            uint8_t prefetch = (packet->type == PREFETCH) ? 1 : 0;
+            if (cache_type == IS_L1I)
+                l1i_prefetcher_cache_fill(access_cpu, ((packet->ip)>>LOG2_BLOCK_SIZE)<<LOG2_BLOCK_SIZE, set, way, prefetch, ((block[set][way].ip)>>LOG2_BLOCK_SIZE)<<LOG2_BLOCK_SIZE);
+            else if (cache_type == IS_L1D)
+                l1d_prefetcher_cache_fill(packet->full_addr, set, way, prefetch, block[set][way].address<<LOG2_BLOCK_SIZE, packet->pf_metadata);
+            else if (cache_type == IS_L2C)
+                packet->pf_metadata = l2c_prefetcher_cache_fill(packet->address<<LOG2_BLOCK_SIZE, set, way, prefetch, block[set][way].address<<LOG2_BLOCK_SIZE, packet->pf_metadata);
+            else if (cache_type == IS_LLC) {
+                cpu = access_cpu;
+                packet->pf_metadata = llc_prefetcher_cache_fill(packet->address<<LOG2_BLOCK_SIZE, set, way, prefetch, block[set][way].address<<LOG2_BLOCK_SIZE, packet->pf_metadata);
+                cpu = 0;
+            }
+
+            // update replacement policy
+            if (cache_type == IS_LLC)
+                llc_update_replacement_state(access_cpu, set, way, packet->full_addr, packet->ip, block[set][way].full_addr, packet->type, 0);
+            else
+                update_replacement_state(access_cpu, set, way, packet->full_addr, packet->ip, block[set][way].full_addr, packet->type, 0);
+
+            fill_cache(set, way, packet);
+
+            if ((packet->type == WRITEBACK) || ((cache_type == IS_L1D) && (packet->type == RFO)))
+                block[set][way].dirty = 1;
+        }
+    }
+
+    // prefetches issued by the training above
+    while (PQ.occupancy) {
+        PACKET prefetch_packet = PQ.entry[PQ.head];
+        PQ.remove_queue(&PQ.entry[PQ.head]);
+        functional_access(&prefetch_packet);
+    }
+}
+
+void CACHE::functional_prefetcher_operate(PACKET *packet, uint8_t hit, uint8_t prefetch_hit)
+{
+    uint64_t block_addr = packet->address << LOG2_BLOCK_SIZE;
+
+    if (cache_type == IS_L1I)
+        l1i_prefetcher_cache_operate(packet->cpu, packet->ip, hit, prefetch_hit);
+    else if (cache_type == IS_L1D)
+        l1d_prefetcher_operate(packet->full_addr, packet->ip, hit, packet->type);
+    else if (cache_type == IS_L2C) {
+        if (packet->type == PREFETCH)
+            packet->pf_metadata = l2c_prefetcher_operate(block_addr, packet->ip, hit, PREFETCH, packet->pf_metadata);
+        else
+            l2c_prefetcher_operate(block_addr, packet->ip, hit, packet->type, 0);
+    }
+    else if (cache_type == IS_LLC) {
+        cpu = packet->cpu;
+        if (packet->type == PREFETCH)
+            packet->pf_metadata = llc_prefetcher_operate(block_addr, packet->ip, hit, PREFETCH, packet->pf_metadata);
+        else
+            llc_prefetcher_operate(block_addr, packet->ip, hit, packet->type, 0);
+        cpu = 0;
+    }
+}
+
+void CACHE::checkpoint(CHECKPOINT &checkpoint)
+{
+    // blocks with their LRU state, the queues and MSHRs are empty at the start of a restored run
+    uint32_t num_set = NUM_SET, num_way = NUM_WAY;
+    checkpoint.transfer(num_set);
+    checkpoint.transfer(num_way);
+    if ((num_set != NUM_SET) || (num_way != NUM_WAY)) {
+        cerr << "[" << NAME << "] " << __func__ << " the checkpoint holds " << num_set << " sets and " << num_way << " ways";
+        cerr << ", this cache has " << NUM_SET << " sets and " << NUM_WAY << " ways" << endl;
+        assert(0);
+    }
+
+    for (uint32_t i=0; i<NUM_SET; i++)
+        checkpoint.transfer(block[i], NUM_WAY);
+
+    if (cache_type == IS_L1D) {
+        if (checkpoint.begin_module(MODULE_L1D_PREFETCHER)) {
+            l1d_prefetcher_checkpoint(checkpoint);
+            checkpoint.end_section();
+        }
+    }
+    else if (cache_type == IS_L2C) {
+        if (checkpoint.begin_module(MODULE_L2C_PREFETCHER)) {
+            l2c_prefetcher_checkpoint(checkpoint);
+            checkpoint.end_section();
+        }
+    }
+    else if (cache_type == IS_LLC) {
+        if (checkpoint.begin_module(MODULE_LLC_PREFETCHER)) {
+            llc_prefetcher_checkpoint(checkpoint);
+            checkpoint.end_section();
+        }
+        if (checkpoint.begin_module(MODULE_LLC_REPLACEMENT)) {
+            llc_replacement_checkpoint(checkpoint);
+            checkpoint.end_section();
+        }
+    }
+}
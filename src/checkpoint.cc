@@ -0,0 +1,162 @@
+#include <zlib.h>
+#include "checkpoint.h"
+#include "module.h"
+
+void CHECKPOINT::read_file(const char *file)
+{
+    gzFile input = gzopen(file, "rb");
+    if (input == NULL) {
+        cerr << "[CHECKPOINT] " << __func__ << " cannot open checkpoint: " << file << endl;
+        assert(0);
+    }
+
+    uint8_t buffer[1 << 16];
+    int bytes;
+    while ((bytes = gzread(input, buffer, sizeof(buffer))) > 0)
+        data.insert(data.end(), buffer, buffer + bytes);
+    if (bytes < 0) {
+        cerr << "[CHECKPOINT] " << __func__ << " cannot read checkpoint: " << file << endl;
+        assert(0);
+    }
+    gzclose(input);
+
+    string magic;
+    uint32_t version = 0;
+    position = 0;
+    if (data.size() > sizeof(uint64_t) + strlen(CHECKPOINT_MAGIC)) {
+        transfer(magic);
+        transfer(version);
+    }
+    if ((magic != CHECKPOINT_MAGIC) || (version != CHECKPOINT_VERSION)) {
+        cerr << "[CHECKPOINT] " << __func__ << " not a version " << CHECKPOINT_VERSION << " checkpoint: " << file << endl;
+        assert(0);
+    }
+}
+
+void CHECKPOINT::write_file(const char *file)
+{
+    vector <uint8_t> state;
+    state.swap(data);
+
+    string magic = CHECKPOINT_MAGIC;
+    uint32_t version = CHECKPOINT_VERSION;
+    transfer(magic);
+    transfer(version);
+    data.insert(data.end(), state.begin(), state.end());
+
+    gzFile output = gzopen(file, "wb");
+    if ((output == NULL) || (gzwrite(output, data.data(), data.size()) != (int)data.size()) || (gzclose(output) != Z_OK)) {
+        cerr << "[CHECKPOINT] " << __func__ << " cannot write checkpoint: " << file << endl;
+        assert(0);
+    }
+}
+
+void CHECKPOINT::transfer_bytes(void *bytes, uint64_t size)
+{
+    if (restoring) {
+        if (position + size > data.size()) {
+            cerr << "[CHECKPOINT] " << __func__ << " the checkpoint ends early, position: " << position << " size: " << size << endl;
+            assert(0);
+        }
+        memcpy(bytes, data.data() + position, size);
+        position += size;
+    }
+    else
+        data.insert(data.end(), (uint8_t *)bytes, (uint8_t *)bytes + size);
+}
+
+void CHECKPOINT::transfer(string &value)
+{
+    uint64_t size = value.size();
+    transfer(size);
+    if (restoring)
+        value.resize(size);
+    transfer(&value[0], size);
+}
+
+void CHECKPOINT::transfer(map <uint64_t, uint64_t> &values)
+{
+    uint64_t size = values.size();
+    transfer(size);
+    if (restoring) {
+        values.clear();
+        for (uint64_t i=0; i<size; i++) {
+            uint64_t key, value;
+            transfer(key);
+            transfer(value);
+            values.insert(values.end(), make_pair(key, value));
+        }
+    }
+    else {
+        for (map <uint64_t, uint64_t>::iterator it = values.begin(); it != values.end(); it++) {
+            uint64_t key = it->first;
+            transfer(key);
+            transfer(it->second);
+        }
+    }
+}
+
+void CHECKPOINT::transfer(queue <uint64_t> &values)
+{
+    // a queue can only be walked by emptying it
+    deque <uint64_t> entries;
+    while (values.size()) {
+        entries.push_back(values.front());
+        values.pop();
+    }
+
+    uint64_t size = entries.size();
+    transfer(size);
+    entries.resize(size);
+    for (uint64_t i=0; i<size; i++) {
+        transfer(entries[i]);
+        values.push(entries[i]);
+    }
+}
+
+void CHECKPOINT::begin_section()
+{
+    uint64_t size = 0;
+    sections.push_back(data.size());
+    transfer(size);
+    if (restoring)
+        sections.back() = position + size;
+}
+
+void CHECKPOINT::end_section()
+{
+    uint64_t mark = sections.back();
+    sections.pop_back();
+
+    if (restoring) {
+        if (position != mark) {
+            cerr << "[CHECKPOINT] " << __func__ << " a part of the checkpoint does not match this build, position: " << position << " expected: " << mark << endl;
+            assert(0);
+        }
+    }
+    else {
+        uint64_t size = data.size() - (mark + sizeof(uint64_t));
+        memcpy(data.data() + mark, &size, sizeof(size));
+    }
+}
+
+void CHECKPOINT::skip_section()
+{
+    position = sections.back();
+    sections.pop_back();
+}
+
+uint8_t CHECKPOINT::begin_module(uint32_t kind)
+{
+    string name = selected_module_name(kind);
+    begin_section();
+    transfer(name);
+
+    if (name != selected_module_name(kind)) {
+        cout << "Checkpoint holds the state of " << name << ", " << selected_module_name(kind) << " starts cold" << endl;
+        skip_section();
+        return 0;
+    }
+
+    return 1;
+}
@@ -0,0 +1,197 @@
+#include "config.h"
+#include <fstream>
+
+// core
+uint32_t FETCH_WIDTH = 6, DECODE_WIDTH = 6, EXEC_WIDTH = 6, LQ_WIDTH = 2, SQ_WIDTH = 2, RETIRE_WIDTH = 4,
+         SCHEDULER_SIZE = 128, BRANCH_MISPREDICT_PENALTY = 1,
+         ROB_SIZE = 352, LQ_SIZE = 128, SQ_SIZE = 72,
+         CPU_FREQ = 4000;
+
+// caches
+uint32_t ITLB_SET = 16, ITLB_WAY = 4, ITLB_RQ_SIZE = 16, ITLB_WQ_SIZE = 16, ITLB_PQ_SIZE = 0, ITLB_MSHR_SIZE = 8, ITLB_LATENCY = 1,
+         DTLB_SET = 16, DTLB_WAY = 4, DTLB_RQ_SIZE = 16, DTLB_WQ_SIZE = 16, DTLB_PQ_SIZE = 0, DTLB_MSHR_SIZE = 8, DTLB_LATENCY = 1,
+         STLB_SET = 128, STLB_WAY = 12, STLB_RQ_SIZE = 32, STLB_WQ_SIZE = 32, STLB_PQ_SIZE = 0, STLB_MSHR_SIZE = 16, STLB_LATENCY = 8,
+         L1I_SET = 64, L1I_WAY = 8, L1I_RQ_SIZE = 64, L1I_WQ_SIZE = 64, L1I_PQ_SIZE = 32, L1I_MSHR_SIZE = 8, L1I_LATENCY = 4,
+         L1D_SET = 64, L1D_WAY = 12, L1D_RQ_SIZE = 64, L1D_WQ_SIZE = 64, L1D_PQ_SIZE = 8, L1D_MSHR_SIZE = 16, L1D_LATENCY = 5,
+         L2C_SET = 1024, L2C_WAY = 8, L2C_RQ_SIZE = 32, L2C_WQ_SIZE = 32, L2C_PQ_SIZE = 16, L2C_MSHR_SIZE = 32, L2C_LATENCY = 10, // 4/5 (L1I or L1D) + 10 = 14/15 cycles
+         LLC_SET = NUM_CPUS*2048, LLC_WAY = 16, LLC_RQ_SIZE = NUM_CPUS*L2C_MSHR_SIZE, LLC_WQ_SIZE = NUM_CPUS*L2C_MSHR_SIZE, LLC_PQ_SIZE = NUM_CPUS*32, LLC_MSHR_SIZE = NUM_CPUS*64, LLC_LATENCY = 20; // 4/5 (L1I or L1D) + 10 + 20 = 34/35 cycles
+
+// DRAM, 4GB off-chip memory by default: 1 channel * 1 rank * 8 banks * 65536 rows * 2KB (128 columns of 64B) per row
+uint32_t DRAM_IO_FREQ = 3200,
+         DRAM_CHANNELS = 1, DRAM_RANKS = 1, DRAM_BANKS = 8, DRAM_ROWS = 65536, DRAM_COLUMNS = 128,
+         LOG2_DRAM_CHANNELS = 0, LOG2_DRAM_RANKS = 0, LOG2_DRAM_BANKS = 3, LOG2_DRAM_ROWS = 16, LOG2_DRAM_COLUMNS = 7,
+         DRAM_WQ_SIZE = 64, DRAM_RQ_SIZE = 64;
+double tRP_DRAM_NANOSECONDS = 12.5, tRCD_DRAM_NANOSECONDS = 12.5, tCAS_DRAM_NANOSECONDS = 12.5;
+
+class config_parameter {
+  public:
+    const char *name;
+    uint32_t *value;
+    uint32_t minimum, maximum;
+    uint8_t power_of_two;
+};
+
+#define CONFIG_CACHE(x) \
+    { #x "_SET", &x##_SET, 1, UINT32_MAX, 1 }, \
+    { #x "_WAY", &x##_WAY, 1, UINT32_MAX, 0 }, \
+    { #x "_RQ_SIZE", &x##_RQ_SIZE, 1, UINT32_MAX, 0 }, \
+    { #x "_WQ_SIZE", &x##_WQ_SIZE, 1, UINT32_MAX, 0 }, \
+    { #x "_PQ_SIZE", &x##_PQ_SIZE, 0, UINT32_MAX, 0 }, \
+    { #x "_MSHR_SIZE", &x##_MSHR_SIZE, 1, UINT32_MAX, 0 }, \
+    { #x "_LATENCY", &x##_LATENCY, 0, UINT32_MAX, 0 }
+
+// the dependency sets of the ROB, LQ and SQ (set.h) hold at most MAX_SIZE indices
+config_parameter config_parameters[] = {
+    { "FETCH_WIDTH", &FETCH_WIDTH, 1, UINT32_MAX, 0 },
+    { "DECODE_WIDTH", &DECODE_WIDTH, 1, UINT32_MAX, 0 },
+    { "EXEC_WIDTH", &EXEC_WIDTH, 1, UINT32_MAX, 0 },
+    { "LQ_WIDTH", &LQ_WIDTH, 1, UINT32_MAX, 0 },
+    { "SQ_WIDTH", &SQ_WIDTH, 1, UINT32_MAX, 0 },
+    { "RETIRE_WIDTH", &RETIRE_WIDTH, 1, UINT32_MAX, 0 },
+    { "SCHEDULER_SIZE", &SCHEDULER_SIZE, 1, UINT32_MAX, 0 },
+    { "BRANCH_MISPREDICT_PENALTY", &BRANCH_MISPREDICT_PENALTY, 0, UINT32_MAX, 0 },
+    { "ROB_SIZE", &ROB_SIZE, 2, MAX_SIZE, 0 },
+    { "LQ_SIZE", &LQ_SIZE, 2, MAX_SIZE, 0 },
+    { "SQ_SIZE", &SQ_SIZE, 2, MAX_SIZE, 0 },
+    { "CPU_FREQ", &CPU_FREQ, 1, UINT32_MAX, 0 },
+    CONFIG_CACHE(ITLB),
+    CONFIG_CACHE(DTLB),
+    CONFIG_CACHE(STLB),
+    CONFIG_CACHE(L1I),
+    CONFIG_CACHE(L1D),
+    CONFIG_CACHE(L2C),
+    CONFIG_CACHE(LLC),
+    { "DRAM_IO_FREQ", &DRAM_IO_FREQ, 4, UINT32_MAX, 0 },
+    { "DRAM_CHANNELS", &DRAM_CHANNELS, 1, DRAM_MAX_CHANNELS, 1 },
+    { "DRAM_RANKS", &DRAM_RANKS, 1, DRAM_MAX_RANKS, 1 },
+    { "DRAM_BANKS", &DRAM_BANKS, 1, DRAM_MAX_BANKS, 1 },
+    { "DRAM_ROWS", &DRAM_ROWS, 1, DRAM_MAX_ROWS, 1 },
+    { "DRAM_COLUMNS", &DRAM_COLUMNS, 1024/BLOCK_SIZE, UINT32_MAX, 1 }, // rows of at least 1KB
+    { "DRAM_WQ_SIZE", &DRAM_WQ_SIZE, 4, UINT32_MAX, 0 },
+    { "DRAM_RQ_SIZE", &DRAM_RQ_SIZE, 1, UINT32_MAX, 0 }
+};
+
+#define NUM_CONFIG_PARAMETERS (sizeof(config_parameters) / sizeof(config_parameters[0]))
+
+class config_timing {
+  public:
+    const char *name;
+    double *value;
+};
+
+config_timing config_timings[] = {
+    { "tRP_DRAM_NANOSECONDS", &tRP_DRAM_NANOSECONDS },
+    { "tRCD_DRAM_NANOSECONDS", &tRCD_DRAM_NANOSECONDS },
+    { "tCAS_DRAM_NANOSECONDS", &tCAS_DRAM_NANOSECONDS }
+};
+
+#define NUM_CONFIG_TIMINGS (sizeof(config_timings) / sizeof(config_timings[0]))
+
+static string trim(const string &s)
+{
+    size_t begin = s.find_first_not_of(" \t\r"),
+           end = s.find_last_not_of(" \t\r");
+    if (begin == string::npos)
+        return "";
+    return s.substr(begin, end - begin + 1);
+}
+
+static uint32_t log2_of(uint32_t value)
+{
+    uint32_t result = 0;
+    while ((1u << result) < value)
+        result++;
+    return result;
+}
+
+void load_config(const char *file)
+{
+    ifstream config_file(file);
+    if (!config_file.is_open()) {
+        cerr << "[CONFIG] " << __func__ << " cannot open config file: " << file << endl;
+        assert(0);
+    }
+
+    cout << "Config file: " << file << endl;
+
+    uint8_t llc_rq_set = 0, llc_wq_set = 0;
+    string line;
+    uint32_t line_number = 0;
+    while (getline(config_file, line)) {
+        line_number++;
+        line = trim(line.substr(0, line.find_first_of("#;")));
+        if (line.empty() || (line[0] == '['))
+            continue;
+
+        size_t separator = line.find('=');
+        string name = trim(line.substr(0, separator)),
+               value = (separator == string::npos) ? "" : trim(line.substr(separator + 1));
+        if (name.empty() || value.empty()) {
+            cerr << "[CONFIG] " << __func__ << " " << file << ":" << line_number << " expected NAME = VALUE: " << line << endl;
+            assert(0);
+        }
+
+        char *end;
+        uint8_t found = 0;
+        for (uint32_t i=0; i<NUM_CONFIG_PARAMETERS; i++) {
+            config_parameter &parameter = config_parameters[i];
+            if (name != parameter.name)
+                continue;
+
+            unsigned long long number = strtoull(value.c_str(), &end, 0);
+            if (*end || (value[0] == '-') || (number < parameter.minimum) || (number > parameter.maximum)
+                || (parameter.power_of_two && (number & (number - 1)))) {
+                cerr << "[CONFIG] " << __func__ << " " << file << ":" << line_number << " invalid " << name << ": " << value;
+                cerr << " (" << parameter.minimum << " to " << parameter.maximum << (parameter.power_of_two ? ", a power of two)" : ")") << endl;
+                assert(0);
+            }
+
+            *parameter.value = (uint32_t)number;
+            found = 1;
+        }
+        for (uint32_t i=0; i<NUM_CONFIG_TIMINGS; i++) {
+            if (name != config_timings[i].name)
+                continue;
+
+            double number = strtod(value.c_str(), &end);
+            if (*end || (number < 0)) {
+                cerr << "[CONFIG] " << __func__ << " " << file << ":" << line_number << " invalid " << name << ": " << value << endl;
+                assert(0);
+            }
+
+            *config_timings[i].value = number;
+            found = 1;
+        }
+        if (!found) {
+            cerr << "[CONFIG] " << __func__ << " " << file << ":" << line_number << " unknown parameter: " << name << endl;
+            assert(0);
+        }
+
+        if (name == "LLC_RQ_SIZE")
+            llc_rq_set = 1;
+        if (name == "LLC_WQ_SIZE")
+            llc_wq_set = 1;
+
+        cout << "  " << name << " = " << value << endl;
+    }
+
+    // the LLC read and write queues hold the misses of every L2C MSHR unless they are given
+    if (!llc_rq_set)
+        LLC_RQ_SIZE = NUM_CPUS*L2C_MSHR_SIZE;
+    if (!llc_wq_set)
+        LLC_WQ_SIZE = NUM_CPUS*L2C_MSHR_SIZE;
+
+    LOG2_DRAM_CHANNELS = log2_of(DRAM_CHANNELS);
+    LOG2_DRAM_RANKS = log2_of(DRAM_RANKS);
+    LOG2_DRAM_BANKS = log2_of(DRAM_BANKS);
+    LOG2_DRAM_ROWS = log2_of(DRAM_ROWS);
+    LOG2_DRAM_COLUMNS = log2_of(DRAM_COLUMNS);
+
+    // physical pages are allocated out of DRAM_PAGES, which has to be at least one and fit in 32 bits
+    uint64_t dram_pages = DRAM_PAGES;
+    if ((dram_pages == 0) || (dram_pages > UINT32_MAX)) {
+        cerr << "[CONFIG] " << __func__ << " " << file << " invalid DRAM size: " << DRAM_SIZE << " MB, " << dram_pages << " pages";
+        cerr << " (1 to " << UINT32_MAX << " pages of " << PAGE_SIZE << " bytes)" << endl;
+        assert(0);
+    }
+}
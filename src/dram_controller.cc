@@ -1,4 +1,5 @@
 #include "dram_controller.h"
+#include "checkpoint.h"
 
 // initialized in main.cc
 uint32_t DRAM_MTPS, DRAM_DBUS_RETURN_TIME,
@@ -120,6 +121,49 @@ void MEMORY_CONTROLLER::operate()
     }
 }
 
+// earliest cycle (not before cycle) at which operate() may do anything, nothing changes before it
+uint64_t MEMORY_CONTROLLER::next_operate_cycle(uint64_t cycle)
+{
+    uint64_t next_cycle = UINT64_MAX;
+
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+        // pending read/write mode switch
+        if ((write_mode[i] == 0) && ((WQ[i].occupancy >= DRAM_WRITE_HIGH_WM) || ((RQ[i].occupancy == 0) && (WQ[i].occupancy > 0))))
+            return cycle;
+        if (write_mode[i] && ((WQ[i].occupancy == 0) || (RQ[i].occupancy && (WQ[i].occupancy < DRAM_WRITE_LOW_WM))))
+            return cycle;
+
+        PACKET_QUEUE *queue = write_mode[i] ? &WQ[i] : &RQ[i];
+
+        // a request waiting for a busy bank is only scheduled once process() frees the bank
+        if (queue->next_schedule_index < queue->SIZE) {
+            if (queue->next_schedule_cycle > cycle) {
+                if (queue->next_schedule_cycle < next_cycle)
+                    next_cycle = queue->next_schedule_cycle;
+            }
+            else {
+                for (uint32_t j=0; j<queue->SIZE; j++) {
+                    uint64_t address = queue->entry[j].address;
+                    if (address && (queue->entry[j].scheduled == 0) && !bank_request[dram_get_channel(address)][dram_get_rank(address)][dram_get_bank(address)].working)
+                        return cycle;
+                }
+            }
+        }
+
+        // the scheduled request is processed once both its own latency and the bank are done
+        if (queue->next_process_index < queue->SIZE) {
+            uint64_t address = queue->entry[queue->next_process_index].address,
+                     process_cycle = bank_request[dram_get_channel(address)][dram_get_rank(address)][dram_get_bank(address)].cycle_available;
+            if (queue->next_process_cycle > process_cycle)
+                process_cycle = queue->next_process_cycle;
+            if (process_cycle < next_cycle)
+                next_cycle = process_cycle;
+        }
+    }
+
+    return (next_cycle < cycle) ? cycle : next_cycle;
+}
+
 void MEMORY_CONTROLLER::schedule(PACKET_QUEUE *queue)
 {
     uint64_t read_addr;
@@ -460,7 +504,7 @@ int MEMORY_CONTROLLER::add_rq(PACKET *packet)
         return index; // merged index
 
     // search for the empty index
-    for (index=0; index<DRAM_RQ_SIZE; index++) {
+    for (index=0; index<(int)DRAM_RQ_SIZE; index++) {
         if (RQ[channel].entry[index].address == 0) {
             
             RQ[channel].entry[index] = *packet;
@@ -502,7 +546,7 @@ int MEMORY_CONTROLLER::add_wq(PACKET *packet)
         return index; // merged index
 
     // search for the empty index
-    for (index=0; index<DRAM_WQ_SIZE; index++) {
+    for (index=0; index<(int)DRAM_WQ_SIZE; index++) {
         if (WQ[channel].entry[index].address == 0) {
             
             WQ[channel].entry[index] = *packet;
@@ -702,3 +746,36 @@ void MEMORY_CONTROLLER::increment_WQ_FULL(uint64_t address)
     uint32_t channel = dram_get_channel(address);
     WQ[channel].FULL++;
 }
+
+void MEMORY_CONTROLLER::functional_access(PACKET *packet)
+{
+    // functional warmup only leaves the row open, nothing is scheduled
+    if (packet->type == WRITEBACK)
+        return;
+
+    bank_request[dram_get_channel(packet->address)][dram_get_rank(packet->address)][dram_get_bank(packet->address)].open_row = dram_get_row(packet->address);
+}
+
+void MEMORY_CONTROLLER::checkpoint(CHECKPOINT &checkpoint)
+{
+    // open rows, only kept for the same DRAM organization
+    uint32_t channels = DRAM_CHANNELS, ranks = DRAM_RANKS, banks = DRAM_BANKS, rows = DRAM_ROWS;
+    checkpoint.begin_section();
+    checkpoint.transfer(channels);
+    checkpoint.transfer(ranks);
+    checkpoint.transfer(banks);
+    checkpoint.transfer(rows);
+    if ((channels != DRAM_CHANNELS) || (ranks != DRAM_RANKS) || (banks != DRAM_BANKS) || (rows != DRAM_ROWS)) {
+        cout << "Checkpoint holds another DRAM organization, every DRAM row starts closed" << endl;
+        checkpoint.skip_section();
+        return;
+    }
+
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+        for (uint32_t j=0; j<DRAM_RANKS; j++) {
+            for (uint32_t k=0; k<DRAM_BANKS; k++)
+                checkpoint.transfer(bank_request[i][j][k].open_row);
+        }
+    }
+    checkpoint.end_section();
+}
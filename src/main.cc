@@ -1,9 +1,16 @@
 #define _BSD_SOURCE
 
 #include <getopt.h>
-#include "ooo_cpu.h"
+#include "config.h"
 #include "uncore.h"
+#include "quantum.h"
+#include "checkpoint.h"
 #include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+#include <cmath>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 uint8_t warmup_complete[NUM_CPUS], 
         simulation_complete[NUM_CPUS], 
@@ -11,19 +18,36 @@ uint8_t warmup_complete[NUM_CPUS],
         all_simulation_complete = 0,
         MAX_INSTR_DESTINATIONS = NUM_INSTR_DESTINATIONS,
         knob_cloudsuite = 0,
-        knob_low_bandwidth = 0;
+        knob_low_bandwidth = 0,
+        knob_derived_cache = 0,
+        knob_functional_warmup = 0,
+        knob_host_stats = 0;
 
 uint64_t warmup_instructions     = 1000000,
          simulation_instructions = 10000000,
+         skip_instructions       = 0,
+         quantum_cycles          = 0,
+         detailed_warmup_instructions = 0,
+         sampling_period         = 0,
+         sampling_window         = 10000,
+         sampling_warmup         = 2000,
          champsim_seed;
 
 time_t start_time;
 
+// host throughput of the whole run (-host_stats), counted from the simulation entry point
+struct timeval host_start_time;
+uint64_t host_start_instr, host_start_cycle;
+
+// statistical sampling, see operate_sampling
+uint8_t sample_draining = 0; // no new instructions enter the core while its pipeline empties before a fast-forward
+
 // PAGE TABLE
 uint32_t PAGE_TABLE_LATENCY = 0, SWAP_LATENCY = 0;
 queue <uint64_t > page_queue;
 map <uint64_t, uint64_t> page_table, inverse_table, recent_page, unique_cl[NUM_CPUS];
 uint64_t previous_ppage, num_adjacent_page, num_cl[NUM_CPUS], allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
+RANDOM champsim_rand(champsim_seed);
 
 void record_roi_stats(uint32_t cpu, CACHE *cache)
 {
@@ -120,18 +144,18 @@ void print_dram_stats()
     cout << "DRAM Statistics" << endl;
     for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
         cout << " CHANNEL " << i << endl;
-        cout << " RQ ROW_BUFFER_HIT: " << setw(10) << uncore.DRAM.RQ[i].ROW_BUFFER_HIT << "  ROW_BUFFER_MISS: " << setw(10) << uncore.DRAM.RQ[i].ROW_BUFFER_MISS << endl;
-        cout << " DBUS_CONGESTED: " << setw(10) << uncore.DRAM.dbus_congested[NUM_TYPES][NUM_TYPES] << endl; 
-        cout << " WQ ROW_BUFFER_HIT: " << setw(10) << uncore.DRAM.WQ[i].ROW_BUFFER_HIT << "  ROW_BUFFER_MISS: " << setw(10) << uncore.DRAM.WQ[i].ROW_BUFFER_MISS;
-        cout << "  FULL: " << setw(10) << uncore.DRAM.WQ[i].FULL << endl; 
+        cout << " RQ ROW_BUFFER_HIT: " << setw(10) << uncore->DRAM.RQ[i].ROW_BUFFER_HIT << "  ROW_BUFFER_MISS: " << setw(10) << uncore->DRAM.RQ[i].ROW_BUFFER_MISS << endl;
+        cout << " DBUS_CONGESTED: " << setw(10) << uncore->DRAM.dbus_congested[NUM_TYPES][NUM_TYPES] << endl; 
+        cout << " WQ ROW_BUFFER_HIT: " << setw(10) << uncore->DRAM.WQ[i].ROW_BUFFER_HIT << "  ROW_BUFFER_MISS: " << setw(10) << uncore->DRAM.WQ[i].ROW_BUFFER_MISS;
+        cout << "  FULL: " << setw(10) << uncore->DRAM.WQ[i].FULL << endl; 
         cout << endl;
     }
 
     uint64_t total_congested_cycle = 0;
     for (uint32_t i=0; i<DRAM_CHANNELS; i++)
-        total_congested_cycle += uncore.DRAM.dbus_cycle_congested[i];
-    if (uncore.DRAM.dbus_congested[NUM_TYPES][NUM_TYPES])
-        cout << " AVG_CONGESTED_CYCLE: " << (total_congested_cycle / uncore.DRAM.dbus_congested[NUM_TYPES][NUM_TYPES]) << endl;
+        total_congested_cycle += uncore->DRAM.dbus_cycle_congested[i];
+    if (uncore->DRAM.dbus_congested[NUM_TYPES][NUM_TYPES])
+        cout << " AVG_CONGESTED_CYCLE: " << (total_congested_cycle / uncore->DRAM.dbus_congested[NUM_TYPES][NUM_TYPES]) << endl;
     else
         cout << " AVG_CONGESTED_CYCLE: -" << endl;
 }
@@ -169,8 +193,100 @@ void reset_cache_stats(uint32_t cpu, CACHE *cache)
     cache->WQ.FULL = 0;
 }
 
+// checkpoint.h
+char *save_checkpoint_file = NULL,
+     *restore_checkpoint_file = NULL;
+CHECKPOINT *restored_checkpoint = NULL;
+
+class checkpoint_core {
+  public:
+    string trace;
+    uint64_t record,  // trace record of the oldest unretired instruction
+             retired,
+             cycle;
+};
+checkpoint_core checkpoint_cores[NUM_CPUS];
+
+// saved first, a restoring run reads it before opening the traces
+void transfer_checkpoint_header(CHECKPOINT &checkpoint)
+{
+    uint32_t num_cpus = NUM_CPUS;
+    uint8_t cloudsuite = knob_cloudsuite;
+    checkpoint.transfer(num_cpus);
+    checkpoint.transfer(cloudsuite);
+    if ((num_cpus != NUM_CPUS) || (cloudsuite != knob_cloudsuite)) {
+        cerr << "[CHECKPOINT] " << __func__ << " the checkpoint was saved with " << num_cpus << " cores" << (cloudsuite ? " and cloudsuite traces" : "");
+        cerr << ", this run has " << NUM_CPUS << " cores" << (knob_cloudsuite ? " and cloudsuite traces" : "") << endl;
+        assert(0);
+    }
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        checkpoint.transfer(checkpoint_cores[i].trace);
+        checkpoint.transfer(checkpoint_cores[i].record);
+        checkpoint.transfer(checkpoint_cores[i].retired);
+        checkpoint.transfer(checkpoint_cores[i].cycle);
+    }
+}
+
+void transfer_checkpoint_state(CHECKPOINT &checkpoint)
+{
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        ooo_cpu[i].checkpoint(checkpoint);
+    uncore->LLC.checkpoint(checkpoint);
+    uncore->DRAM.checkpoint(checkpoint);
+
+    // page tables, unique_cl and num_cl are statistics only
+    checkpoint.transfer(page_table);
+    checkpoint.transfer(inverse_table);
+    checkpoint.transfer(recent_page);
+    checkpoint.transfer(page_queue);
+    checkpoint.transfer(previous_ppage);
+    checkpoint.transfer(num_adjacent_page);
+    checkpoint.transfer(allocated_pages);
+    checkpoint.transfer(num_page, NUM_CPUS);
+    checkpoint.transfer(minor_fault, NUM_CPUS);
+    checkpoint.transfer(major_fault, NUM_CPUS);
+
+    // the physical page allocator, the engine only has a portable text form
+    stringstream engine;
+    engine << champsim_rand.engine;
+    string engine_state = engine.str();
+    checkpoint.transfer(engine_state);
+    if (checkpoint.restoring) {
+        engine.str(engine_state);
+        engine >> champsim_rand.engine;
+    }
+}
+
+void save_checkpoint()
+{
+    CHECKPOINT checkpoint(0);
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        checkpoint_cores[i].trace = ooo_cpu[i].trace_string;
+        checkpoint_cores[i].record = ooo_cpu[i].trace_record(ooo_cpu[i].num_retired);
+        checkpoint_cores[i].retired = ooo_cpu[i].num_retired;
+        checkpoint_cores[i].cycle = current_core_cycle[i];
+    }
+    transfer_checkpoint_header(checkpoint);
+    transfer_checkpoint_state(checkpoint);
+
+    checkpoint.write_file(save_checkpoint_file);
+    cout << "Saved checkpoint: " << save_checkpoint_file << endl;
+}
+
+// the trace name without its directory, a checkpoint still applies to a trace that moved
+string trace_basename(string trace)
+{
+    size_t slash = trace.find_last_of('/');
+    return (slash == string::npos) ? trace : trace.substr(slash + 1);
+}
+
 void finish_warmup()
 {
+    if (save_checkpoint_file)
+        save_checkpoint();
+
     uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
              elapsed_minute = elapsed_second / 60,
              elapsed_hour = elapsed_minute / 60;
@@ -207,16 +323,16 @@ void finish_warmup()
         reset_cache_stats(i, &ooo_cpu[i].L1I);
         reset_cache_stats(i, &ooo_cpu[i].L1D);
         reset_cache_stats(i, &ooo_cpu[i].L2C);
-        reset_cache_stats(i, &uncore.LLC);
+        reset_cache_stats(i, &uncore->LLC);
     }
     cout << endl;
 
     // reset DRAM stats
     for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
-        uncore.DRAM.RQ[i].ROW_BUFFER_HIT = 0;
-        uncore.DRAM.RQ[i].ROW_BUFFER_MISS = 0;
-        uncore.DRAM.WQ[i].ROW_BUFFER_HIT = 0;
-        uncore.DRAM.WQ[i].ROW_BUFFER_MISS = 0;
+        uncore->DRAM.RQ[i].ROW_BUFFER_HIT = 0;
+        uncore->DRAM.RQ[i].ROW_BUFFER_MISS = 0;
+        uncore->DRAM.WQ[i].ROW_BUFFER_HIT = 0;
+        uncore->DRAM.WQ[i].ROW_BUFFER_MISS = 0;
     }
 
     // set actual cache latency
@@ -228,7 +344,30 @@ void finish_warmup()
         ooo_cpu[i].L1D.LATENCY  = L1D_LATENCY;
         ooo_cpu[i].L2C.LATENCY  = L2C_LATENCY;
     }
-    uncore.LLC.LATENCY = LLC_LATENCY;
+    uncore->LLC.LATENCY = LLC_LATENCY;
+}
+
+// every core resumes at the oldest instruction it had not retired when the checkpoint was saved
+void restore_checkpoint()
+{
+    transfer_checkpoint_state(*restored_checkpoint);
+    delete restored_checkpoint;
+    restored_checkpoint = NULL;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        ooo_cpu[i].num_retired = checkpoint_cores[i].retired;
+        ooo_cpu[i].instr_unique_id = checkpoint_cores[i].retired;
+        ooo_cpu[i].last_sim_instr = checkpoint_cores[i].retired;
+        ooo_cpu[i].next_print_instruction = (checkpoint_cores[i].retired / STAT_PRINTING_PERIOD + 1) * STAT_PRINTING_PERIOD;
+        current_core_cycle[i] = checkpoint_cores[i].cycle;
+        ooo_cpu[i].last_sim_cycle = checkpoint_cores[i].cycle;
+        warmup_complete[i] = 1;
+    }
+
+    cout << "Restored checkpoint: " << restore_checkpoint_file << endl;
+    start_time = time(NULL);
+    all_warmup_complete = NUM_CPUS + 1;
+    finish_warmup();
 }
 
 void print_deadlock(uint32_t i)
@@ -302,7 +441,21 @@ uint64_t rotr64 (uint64_t n, unsigned int c)
     return (n>>c) | (n<<( (-c)&mask ));
 }
 
-RANDOM champsim_rand(champsim_seed);
+// cycle each core thread is working on in parallel runs (quantum.h)
+CORE_PROGRESS core_progress;
+uint8_t parallel_cores_running = 0; // the functional warmup translates on the main thread before the cores start
+
+// parallel runs translate in the (cycle, cpu) order of the serial loop, which keeps the page allocation deterministic:
+// wait until the cores before this one are past this cycle and the ones after it have reached it
+void wait_page_table_turn(uint32_t cpu)
+{
+    uint64_t cycle = current_core_cycle[cpu];
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        if (i != cpu)
+            core_progress.wait(i, (i < cpu) ? cycle + 1 : cycle);
+    }
+}
+
 uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_vpage, uint8_t is_code)
 {
 #ifdef SANITY_CHECK
@@ -310,6 +463,9 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
         assert(0);
 #endif
 
+    if (parallel_cores_running)
+        wait_page_table_turn(cpu);
+
     uint8_t  swap = 0;
     uint64_t high_bit_mask = rotr64(cpu, lg2(NUM_CPUS)),
              unique_va = va | high_bit_mask;
@@ -391,7 +547,7 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
                 ooo_cpu[cpu].L1I.invalidate_entry(cl_addr);
                 ooo_cpu[cpu].L1D.invalidate_entry(cl_addr);
                 ooo_cpu[cpu].L2C.invalidate_entry(cl_addr);
-                uncore.LLC.invalidate_entry(cl_addr);
+                uncore->LLC.invalidate_entry(cl_addr);
             }
 
             // swap complete
@@ -497,6 +653,909 @@ void cpu_l1i_prefetcher_cache_fill(uint32_t cpu_num, uint64_t addr, uint32_t set
   ooo_cpu[cpu_num].l1i_prefetcher_cache_fill(addr, set, way, prefetch, evicted_addr);
 }
 
+void print_elapsed_time(ostream &out)
+{
+    uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
+             elapsed_minute = elapsed_second / 60,
+             elapsed_hour = elapsed_minute / 60;
+    elapsed_minute -= elapsed_hour*60;
+    elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
+
+    out << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
+}
+
+void start_host_stats()
+{
+    gettimeofday(&host_start_time, NULL);
+    host_start_instr = 0;
+    host_start_cycle = 0;
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        host_start_instr += ooo_cpu[i].num_retired;
+        if (current_core_cycle[i] > host_start_cycle)
+            host_start_cycle = current_core_cycle[i];
+    }
+}
+
+// instructions and cycles simulated per host second and the peak resident memory on one line, parsed by scripts/benchmark.sh
+void print_host_stats()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    double seconds = (now.tv_sec - host_start_time.tv_sec) + (now.tv_usec - host_start_time.tv_usec) / 1000000.0;
+    if (seconds <= 0)
+        seconds = 1e-6;
+
+    uint64_t instructions = 0, cycles = 0;
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        instructions += ooo_cpu[i].num_retired;
+        if (current_core_cycle[i] > cycles)
+            cycles = current_core_cycle[i];
+    }
+    instructions -= host_start_instr;
+    cycles -= host_start_cycle;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    cout << endl << "Host statistics" << endl;
+    cout << "Host seconds: " << seconds << " instructions: " << instructions << " cycles: " << cycles;
+    cout << " KIPS: " << instructions / seconds / 1000 << " cycles/s: " << (uint64_t)(cycles / seconds);
+    cout << " peak RSS KB: " << usage.ru_maxrss << endl;
+}
+
+// one cycle of core i and its private caches
+void operate_cpu(uint32_t i, uint8_t show_heartbeat, ostream &out)
+{
+    //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
+    //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
+
+    // core might be stalled due to page fault or branch misprediction
+    if (stall_cycle[i] <= current_core_cycle[i]) {
+
+      // retire
+      if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
+	ooo_cpu[i].retire_rob();
+
+      // complete 
+      ooo_cpu[i].update_rob();
+
+      // schedule
+      uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
+      if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
+	ooo_cpu[i].schedule_instruction();
+      // execute
+      ooo_cpu[i].execute_instruction();
+
+      ooo_cpu[i].update_rob();
+
+      // memory operation
+      ooo_cpu[i].schedule_memory_instruction();
+      ooo_cpu[i].execute_memory_instruction();
+
+      ooo_cpu[i].update_rob();
+
+      // decode
+      if(ooo_cpu[i].DECODE_BUFFER.occupancy > 0)
+	{
+	  ooo_cpu[i].decode_and_dispatch();
+	}
+      
+      // fetch
+      ooo_cpu[i].fetch_instruction();
+      
+      // read from trace
+      if ((ooo_cpu[i].IFETCH_BUFFER.occupancy < ooo_cpu[i].IFETCH_BUFFER.SIZE) && (ooo_cpu[i].fetch_stall == 0) && (sample_draining == 0))
+	{
+	  ooo_cpu[i].read_from_trace();
+	}
+    }
+
+    // heartbeat information
+    if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction)) {
+        float cumulative_ipc;
+        if (warmup_complete[i])
+            cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
+        else
+            cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
+        float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
+
+        out << "Heartbeat CPU " << i << " instructions: " << ooo_cpu[i].num_retired << " cycles: " << current_core_cycle[i];
+        out << " heartbeat IPC: " << heartbeat_ipc << " cumulative IPC: " << cumulative_ipc; 
+        print_elapsed_time(out);
+        ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
+
+        ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
+        ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
+    }
+
+    // check for deadlock
+    if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
+        print_deadlock(i);
+}
+
+void finish_cpu_simulation(uint32_t i, ostream &out)
+{
+    simulation_complete[i] = 1;
+    ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
+    ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
+
+    out << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
+    out << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
+    print_elapsed_time(out);
+
+    record_roi_stats(i, &ooo_cpu[i].L1D);
+    record_roi_stats(i, &ooo_cpu[i].L1I);
+    record_roi_stats(i, &ooo_cpu[i].L2C);
+    record_roi_stats(i, &uncore->LLC);
+}
+
+// functional warmup (-detailed_warmup_instructions N): the first warmup_instructions - N instructions of every core
+// only update the caches, TLBs, page table, branch predictor and prefetchers (O3_CPU::functional_instruction),
+// the cores take turns one instruction at a time so they share the LLC and the page table as in a detailed run.
+// the last N instructions go through the detailed model to fill the pipelines, queues and DRAM timing.
+void run_functional_warmup()
+{
+    uint64_t functional_instructions = warmup_instructions - detailed_warmup_instructions;
+
+    for (uint64_t instr=0; instr<functional_instructions; instr++)
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            ooo_cpu[i].functional_instruction();
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
+        ooo_cpu[i].next_print_instruction = (ooo_cpu[i].num_retired / STAT_PRINTING_PERIOD + 1) * STAT_PRINTING_PERIOD;
+
+        cout << "Functional warmup complete CPU " << i << " instructions: " << ooo_cpu[i].num_retired;
+        print_elapsed_time(cout);
+    }
+}
+
+// parallel multi-core simulation, see quantum.h
+void run_parallel_simulation(uint8_t show_heartbeat)
+{
+    LLC_PORT llc_port[NUM_CPUS];
+    ostringstream core_output[NUM_CPUS];
+    QUANTUM_BARRIER barrier(NUM_CPUS + 1);
+    uint64_t quantum_begin = current_core_cycle[0] + 1, quantum_end = current_core_cycle[0] + quantum_cycles; // a restored checkpoint starts late
+    uint8_t run_simulation = 1;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        llc_port[i].llc = &uncore->LLC;
+        ooo_cpu[i].L2C.lower_level = &llc_port[i];
+        core_progress.set(i, quantum_begin);
+    }
+    parallel_cores_running = 1;
+
+    vector <thread> core_threads;
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        core_threads.push_back(thread([&, i] {
+            while (1) {
+                barrier.wait();
+                if (run_simulation == 0)
+                    return;
+
+                while (current_core_cycle[i] < quantum_end) {
+                    current_core_cycle[i]++;
+                    core_progress.set(i, current_core_cycle[i]);
+
+                    operate_cpu(i, show_heartbeat, core_output[i]);
+
+                    // warmup and the end of the simulation are counted at the end of the quantum
+                    if ((warmup_complete[i] == 0) && (ooo_cpu[i].num_retired > warmup_instructions))
+                        warmup_complete[i] = 1;
+                    if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions)))
+                        finish_cpu_simulation(i, core_output[i]);
+                }
+                core_progress.set(i, quantum_end + 1);
+
+                barrier.wait();
+            }
+        }));
+    }
+
+    while (run_simulation) {
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            llc_port[i].begin_quantum(i);
+
+        // cores
+        barrier.wait();
+        barrier.wait();
+
+        // uncore, with the requests of each cycle delivered in cpu order before it operates
+        for (uint64_t cycle=quantum_begin; cycle<=quantum_end; cycle++) {
+            for (uint32_t i=0; i<NUM_CPUS; i++)
+                current_core_cycle[i] = cycle;
+            for (uint32_t i=0; i<NUM_CPUS; i++)
+                llc_port[i].deliver(cycle);
+
+            uncore->DRAM.operate();
+            uncore->LLC.operate();
+        }
+
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            cout << core_output[i].str();
+            core_output[i].str("");
+        }
+
+        if (all_warmup_complete < NUM_CPUS) {
+            all_warmup_complete = 0;
+            for (uint32_t i=0; i<NUM_CPUS; i++)
+                all_warmup_complete += warmup_complete[i];
+        }
+        if (all_warmup_complete == NUM_CPUS) {
+            all_warmup_complete++;
+            finish_warmup();
+        }
+
+        all_simulation_complete = 0;
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            all_simulation_complete += simulation_complete[i];
+        if (all_simulation_complete == NUM_CPUS)
+            run_simulation = 0;
+
+        quantum_begin = quantum_end + 1;
+        quantum_end += quantum_cycles;
+    }
+
+    // release the core threads one last time so that they see the end of the simulation
+    barrier.wait();
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        core_threads[i].join();
+        ooo_cpu[i].L2C.lower_level = &uncore->LLC;
+    }
+}
+
+// when no core has anything to do in the next cycle, whether stalled on a page fault or waiting on memory
+// (O3_CPU::next_operate_cycle), and the uncore is idle as well, jump straight to the cycle before the next one that has any work
+void skip_idle_cycles()
+{
+    uint64_t cycle = current_core_cycle[0] + 1, // the next cycle to simulate
+             next_cycle = UINT64_MAX;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        uint64_t core_cycle = ooo_cpu[i].next_operate_cycle();
+        if (core_cycle <= cycle)
+            return;
+        if (core_cycle < next_cycle)
+            next_cycle = core_cycle;
+
+        // keep the deadlock check on time
+        uint32_t head = ooo_cpu[i].ROB.head;
+        if (ooo_cpu[i].ROB.entry[head].ip && (ooo_cpu[i].ROB.entry[head].event_cycle + DEADLOCK_CYCLE < next_cycle))
+            next_cycle = ooo_cpu[i].ROB.entry[head].event_cycle + DEADLOCK_CYCLE;
+    }
+
+    uint64_t uncore_cycle = uncore->LLC.next_operate_cycle();
+    if (uncore_cycle < next_cycle)
+        next_cycle = uncore_cycle;
+    uncore_cycle = uncore->DRAM.next_operate_cycle(cycle);
+    if (uncore_cycle < next_cycle)
+        next_cycle = uncore_cycle;
+
+    if ((next_cycle <= cycle) || (next_cycle == UINT64_MAX))
+        return;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        current_core_cycle[i] = next_cycle - 1;
+}
+
+// simpoint regions, every region runs in its own forked simulator since the cores and the uncore are globals
+#define NUM_SIMPOINT_CACHES 4
+
+class simpoint_region {
+  public:
+    string trace;
+    double weight;
+    uint64_t skip_instructions;
+};
+
+class simpoint_result {
+  public:
+    uint64_t instructions, cycles, branch_mispredictions,
+             roi_instructions, // instructions retired while the branch mispredictions were counted
+             access[NUM_SIMPOINT_CACHES], miss[NUM_SIMPOINT_CACHES];
+};
+
+const char *simpoint_cache_name[NUM_SIMPOINT_CACHES] = { "L1D", "L1I", "L2C", "LLC" };
+
+// one region per line: trace weight [skip_instructions], '#' starts a comment
+vector <simpoint_region> read_simpoints(const char *list_name)
+{
+    vector <simpoint_region> regions;
+    ifstream list(list_name);
+    if (!list.good()) {
+        cerr << "[SIMPOINT] " << __func__ << " cannot open " << list_name << endl;
+        assert(0);
+    }
+
+    string line;
+    while (getline(list, line)) {
+        line = line.substr(0, line.find('#'));
+
+        simpoint_region region;
+        region.skip_instructions = 0;
+        istringstream fields(line);
+        if (!(fields >> region.trace))
+            continue;
+        if (!(fields >> region.weight) || (region.weight < 0)) {
+            cerr << "[SIMPOINT] " << __func__ << " missing or negative weight: " << line << endl;
+            assert(0);
+        }
+        fields >> region.skip_instructions;
+
+        regions.push_back(region);
+    }
+
+    if (regions.empty()) {
+        cerr << "[SIMPOINT] " << __func__ << " no regions in " << list_name << endl;
+        assert(0);
+    }
+
+    return regions;
+}
+
+void collect_simpoint_result(uint32_t cpu, simpoint_result *result)
+{
+    CACHE *cache[NUM_SIMPOINT_CACHES] = { &ooo_cpu[cpu].L1D, &ooo_cpu[cpu].L1I, &ooo_cpu[cpu].L2C, &uncore->LLC };
+
+    result->instructions = ooo_cpu[cpu].finish_sim_instr;
+    result->cycles = ooo_cpu[cpu].finish_sim_cycle;
+    result->branch_mispredictions = ooo_cpu[cpu].branch_mispredictions;
+    result->roi_instructions = ooo_cpu[cpu].num_retired - ooo_cpu[cpu].warmup_instructions;
+    for (uint32_t i=0; i<NUM_SIMPOINT_CACHES; i++) {
+        result->access[i] = 0;
+        result->miss[i] = 0;
+        for (uint32_t j=0; j<NUM_TYPES; j++) {
+            result->access[i] += cache[i]->roi_access[cpu][j];
+            result->miss[i] += cache[i]->roi_miss[cpu][j];
+        }
+    }
+}
+
+void print_simpoint_stats(vector <simpoint_region> &regions, vector <simpoint_result> &results)
+{
+    double total_weight = 0, weighted_cpi = 0, weighted_branch_mpki = 0,
+           weighted_mpki[NUM_SIMPOINT_CACHES] = {}, weighted_apki[NUM_SIMPOINT_CACHES] = {};
+
+    for (uint32_t i=0; i<regions.size(); i++)
+        total_weight += regions[i].weight;
+    if (total_weight == 0) {
+        cerr << "[SIMPOINT] " << __func__ << " all region weights are zero" << endl;
+        assert(0);
+    }
+
+    cout << endl << "SimPoint Region Statistics" << endl;
+    for (uint32_t i=0; i<regions.size(); i++) {
+        double weight = regions[i].weight / total_weight,
+               ipc = (1.0*results[i].instructions) / results[i].cycles;
+
+        cout << endl << "Region " << i << " " << regions[i].trace << " weight: " << weight;
+        cout << " IPC: " << ipc << " instructions: " << results[i].instructions << " cycles: " << results[i].cycles << endl;
+
+        weighted_cpi += weight / ipc;
+        if (results[i].roi_instructions)
+            weighted_branch_mpki += weight * (1000.0*results[i].branch_mispredictions) / results[i].roi_instructions;
+
+        for (uint32_t j=0; j<NUM_SIMPOINT_CACHES; j++) {
+            double mpki = (1000.0*results[i].miss[j]) / results[i].instructions,
+                   apki = (1000.0*results[i].access[j]) / results[i].instructions,
+                   miss_rate = results[i].access[j] ? (1.0*results[i].miss[j]) / results[i].access[j] : 0;
+
+            cout << simpoint_cache_name[j] << " ACCESS: " << setw(10) << results[i].access[j] << "  MISS: " << setw(10) << results[i].miss[j];
+            cout << "  MPKI: " << mpki << "  MISS RATE: " << miss_rate << endl;
+
+            weighted_mpki[j] += weight * mpki;
+            weighted_apki[j] += weight * apki;
+        }
+    }
+
+    cout << endl << "SimPoint Weighted Statistics" << endl << endl;
+    // regions are weighted by their share of instructions, so their CPIs add up and the IPC is the inverse
+    cout << "Weighted IPC: " << 1.0/weighted_cpi << " (weighted CPI: " << weighted_cpi << ")" << endl;
+    cout << "Weighted branch MPKI: " << weighted_branch_mpki << endl;
+    // the miss rate is weighted through the accesses per instruction, as the ratio of the weighted MPKI to the weighted APKI
+    for (uint32_t j=0; j<NUM_SIMPOINT_CACHES; j++)
+        cout << simpoint_cache_name[j] << " weighted MPKI: " << weighted_mpki[j] << "  weighted MISS RATE: " << (weighted_apki[j] ? weighted_mpki[j] / weighted_apki[j] : 0) << endl;
+}
+
+// forks up to num_jobs simulators at a time, one per region
+// returns the region index in the child, which goes on to simulate it, and -1 in the parent once every region is done
+int run_simpoints(vector <simpoint_region> &regions, uint32_t num_jobs, const char *list_name, int *result_fd)
+{
+    vector <simpoint_result> results(regions.size());
+    map <pid_t, pair <uint32_t, int> > running;
+    uint32_t next_region = 0, failed = 0;
+
+    cout << "SimPoint regions: " << regions.size() << " jobs: " << num_jobs << endl;
+
+    while ((next_region < regions.size()) || !running.empty()) {
+        if ((next_region < regions.size()) && (running.size() < num_jobs)) {
+            int fd[2];
+            if (pipe(fd)) {
+                cerr << "[SIMPOINT] " << __func__ << " pipe failed" << endl;
+                assert(0);
+            }
+
+            // nothing buffered may be written twice
+            cout.flush();
+            fflush(stdout);
+
+            pid_t pid = fork();
+            if (pid < 0) {
+                cerr << "[SIMPOINT] " << __func__ << " fork failed" << endl;
+                assert(0);
+            }
+            if (pid == 0) {
+                close(fd[0]);
+                *result_fd = fd[1];
+
+                // the full report of every region goes next to the region list
+                string output_name = string(list_name) + ".region" + to_string(next_region) + ".txt";
+                if (freopen(output_name.c_str(), "w", stdout) == NULL) {
+                    cerr << "[SIMPOINT] " << __func__ << " cannot open " << output_name << endl;
+                    assert(0);
+                }
+
+                return next_region;
+            }
+
+            close(fd[1]);
+            cout << "Region " << next_region << " runs " << regions[next_region].trace;
+            if (regions[next_region].skip_instructions)
+                cout << " from instruction " << regions[next_region].skip_instructions;
+            cout << endl;
+
+            running[pid] = make_pair(next_region, fd[0]);
+            next_region++;
+            continue;
+        }
+
+        int status;
+        pid_t pid = wait(&status);
+        map <pid_t, pair <uint32_t, int> >::iterator job = running.find(pid);
+        if (job == running.end())
+            continue;
+
+        uint32_t region = job->second.first;
+        int fd = job->second.second;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) || (read(fd, &results[region], sizeof(simpoint_result)) != sizeof(simpoint_result))) {
+            cerr << "*** Region " << region << " (" << regions[region].trace << ") did not complete ***" << endl;
+            failed++;
+        }
+        close(fd);
+        running.erase(job);
+    }
+
+    if (failed) {
+        cerr << "[SIMPOINT] " << __func__ << " " << failed << " region(s) failed" << endl;
+        assert(0);
+    }
+
+    print_simpoint_stats(regions, results);
+
+    return -1;
+}
+
+// statistical sampling (-sampling_period P), SMARTS-style systematic sampling of the region of interest on a single core.
+// every period of P instructions is fast-forwarded in the functional model (O3_CPU::functional_instruction) up to
+// sampling_warmup + sampling_window instructions before its end, then the detailed model runs sampling_warmup
+// instructions to refill the pipeline and measures the next sampling_window instructions.
+// the core then stops fetching until the pipeline and the caches are empty, and the next period starts.
+// every window is one sample, the estimates come with their 95% confidence interval.
+#define SAMPLE_DRAIN 0
+#define SAMPLE_WARMUP 1
+#define SAMPLE_MEASURE 2
+
+uint8_t sample_phase = SAMPLE_DRAIN;
+uint64_t sample_period_index = 0,
+         sample_phase_end,  // num_retired that ends the detailed warmup or the window
+         sample_begin_instr, sample_begin_cycle, sample_begin_mispredictions,
+         sample_access[NUM_SIMPOINT_CACHES][NUM_TYPES], sample_hit[NUM_SIMPOINT_CACHES][NUM_TYPES], sample_miss[NUM_SIMPOINT_CACHES][NUM_TYPES];
+vector <simpoint_result> sample_windows;
+
+void sampled_caches(CACHE **cache)
+{
+    cache[0] = &ooo_cpu[0].L1D;
+    cache[1] = &ooo_cpu[0].L1I;
+    cache[2] = &ooo_cpu[0].L2C;
+    cache[3] = &uncore->LLC;
+}
+
+uint8_t sample_drained()
+{
+    O3_CPU *core = &ooo_cpu[0];
+    if (core->ROB.occupancy || core->IFETCH_BUFFER.occupancy || core->DECODE_BUFFER.occupancy || core->LQ.occupancy || core->SQ.occupancy)
+        return 0;
+
+    CACHE *cache[7] = { &core->ITLB, &core->DTLB, &core->STLB, &core->L1I, &core->L1D, &core->L2C, &uncore->LLC };
+    for (uint32_t i=0; i<7; i++)
+        if (cache[i]->RQ.occupancy || cache[i]->WQ.occupancy || cache[i]->PQ.occupancy || cache[i]->MSHR.occupancy)
+            return 0;
+
+    return 1;
+}
+
+// the roi counters (record_roi_stats) hold the cache statistics at the start of the window
+void begin_sample_window()
+{
+    CACHE *cache[NUM_SIMPOINT_CACHES];
+    sampled_caches(cache);
+    for (uint32_t i=0; i<NUM_SIMPOINT_CACHES; i++)
+        record_roi_stats(0, cache[i]);
+
+    sample_begin_instr = ooo_cpu[0].num_retired;
+    sample_begin_cycle = current_core_cycle[0];
+    sample_begin_mispredictions = ooo_cpu[0].branch_mispredictions;
+}
+
+void end_sample_window()
+{
+    CACHE *cache[NUM_SIMPOINT_CACHES];
+    sampled_caches(cache);
+
+    simpoint_result window;
+    window.instructions = ooo_cpu[0].num_retired - sample_begin_instr;
+    window.cycles = current_core_cycle[0] - sample_begin_cycle;
+    window.roi_instructions = window.instructions;
+    window.branch_mispredictions = ooo_cpu[0].branch_mispredictions - sample_begin_mispredictions;
+    for (uint32_t i=0; i<NUM_SIMPOINT_CACHES; i++) {
+        window.access[i] = 0;
+        window.miss[i] = 0;
+        for (uint32_t j=0; j<NUM_TYPES; j++) {
+            uint64_t access = cache[i]->sim_access[0][j] - cache[i]->roi_access[0][j],
+                     hit = cache[i]->sim_hit[0][j] - cache[i]->roi_hit[0][j],
+                     miss = cache[i]->sim_miss[0][j] - cache[i]->roi_miss[0][j];
+
+            window.access[i] += access;
+            window.miss[i] += miss;
+            sample_access[i][j] += access;
+            sample_hit[i][j] += hit;
+            sample_miss[i][j] += miss;
+        }
+    }
+    sample_windows.push_back(window);
+}
+
+// the region of interest statistics become the sum of the windows
+void finish_sampling(ostream &out)
+{
+    CACHE *cache[NUM_SIMPOINT_CACHES];
+    sampled_caches(cache);
+    for (uint32_t i=0; i<NUM_SIMPOINT_CACHES; i++) {
+        for (uint32_t j=0; j<NUM_TYPES; j++) {
+            cache[i]->roi_access[0][j] = sample_access[i][j];
+            cache[i]->roi_hit[0][j] = sample_hit[i][j];
+            cache[i]->roi_miss[0][j] = sample_miss[i][j];
+        }
+    }
+
+    ooo_cpu[0].finish_sim_instr = 0;
+    ooo_cpu[0].finish_sim_cycle = 0;
+    for (uint32_t i=0; i<sample_windows.size(); i++) {
+        ooo_cpu[0].finish_sim_instr += sample_windows[i].instructions;
+        ooo_cpu[0].finish_sim_cycle += sample_windows[i].cycles;
+    }
+    simulation_complete[0] = 1;
+
+    out << "Finished CPU 0 sampled windows: " << sample_windows.size() << " instructions: " << ooo_cpu[0].finish_sim_instr << " cycles: " << ooo_cpu[0].finish_sim_cycle;
+    out << " cumulative IPC: " << ((float) ooo_cpu[0].finish_sim_instr / ooo_cpu[0].finish_sim_cycle);
+    print_elapsed_time(out);
+}
+
+// called every cycle of the region of interest, returns 1 once the last window is measured
+uint8_t operate_sampling(ostream &out)
+{
+    O3_CPU *core = &ooo_cpu[0];
+
+    if ((sample_phase == SAMPLE_WARMUP) && (core->num_retired >= sample_phase_end)) {
+        begin_sample_window();
+        sample_phase = SAMPLE_MEASURE;
+        sample_phase_end = core->num_retired + sampling_window;
+    }
+    else if ((sample_phase == SAMPLE_MEASURE) && (core->num_retired >= sample_phase_end)) {
+        end_sample_window();
+        sample_phase = SAMPLE_DRAIN;
+    }
+    else if (sample_phase == SAMPLE_DRAIN) {
+        // the region of interest also starts with a drain, right after the warmup
+        sample_draining = 1;
+        if (sample_drained() == 0)
+            return 0;
+        sample_draining = 0;
+
+        uint64_t period_end = core->begin_sim_instr + (sample_period_index + 1) * sampling_period;
+        if (period_end > core->begin_sim_instr + simulation_instructions) {
+            finish_sampling(out);
+            return 1;
+        }
+        sample_period_index++;
+
+        // the drain may have run past the fast-forward of this period
+        while (core->num_retired + sampling_warmup + sampling_window < period_end)
+            core->functional_instruction();
+
+        core->last_sim_instr = core->num_retired;
+        core->last_sim_cycle = current_core_cycle[0];
+        core->next_print_instruction = (core->num_retired / STAT_PRINTING_PERIOD + 1) * STAT_PRINTING_PERIOD;
+
+        sample_phase = SAMPLE_WARMUP;
+        sample_phase_end = core->num_retired + sampling_warmup;
+        if (sample_phase_end + sampling_window > period_end)
+            sample_phase_end = period_end - sampling_window;
+    }
+
+    return 0;
+}
+
+// the drain ends on the first cycle the pipeline is empty, no cycle is skipped until then
+uint8_t sample_drain_pending()
+{
+    return sampling_period && (all_warmup_complete > NUM_CPUS) && (sample_phase == SAMPLE_DRAIN);
+}
+
+// mean and half-width of its 95% confidence interval, 0 with less than two samples
+void sample_interval(vector <double> &samples, double *mean, double *half_width)
+{
+    double sum = 0, square_sum = 0, n = samples.size();
+    for (uint32_t i=0; i<samples.size(); i++) {
+        sum += samples[i];
+        square_sum += samples[i] * samples[i];
+    }
+
+    *mean = n ? sum / n : 0;
+    *half_width = 0;
+    if (n > 1) {
+        double variance = (square_sum - n * (*mean) * (*mean)) / (n - 1);
+        *half_width = 1.96 * sqrt(variance > 0 ? variance : 0) / sqrt(n);
+    }
+}
+
+void print_sample_estimate(const char *name, vector <double> &samples)
+{
+    double mean, half_width;
+    sample_interval(samples, &mean, &half_width);
+
+    cout << name << ": " << mean << " +- " << half_width;
+    if (mean)
+        cout << " (" << 100.0 * half_width / mean << "%)";
+    cout << endl;
+}
+
+void print_sampling_stats()
+{
+    uint32_t num_windows = sample_windows.size();
+    vector <double> cpi, branch_mpki, mpki[NUM_SIMPOINT_CACHES];
+    for (uint32_t i=0; i<num_windows; i++) {
+        cpi.push_back((1.0*sample_windows[i].cycles) / sample_windows[i].instructions);
+        branch_mpki.push_back((1000.0*sample_windows[i].branch_mispredictions) / sample_windows[i].instructions);
+        for (uint32_t j=0; j<NUM_SIMPOINT_CACHES; j++)
+            mpki[j].push_back((1000.0*sample_windows[i].miss[j]) / sample_windows[i].instructions);
+    }
+
+    cout << endl << "Sampling Statistics (95% confidence intervals)" << endl << endl;
+    cout << "Windows: " << num_windows << " period: " << sampling_period << " window: " << sampling_window << " detailed warmup: " << sampling_warmup << endl;
+
+    double mean, half_width;
+    sample_interval(cpi, &mean, &half_width);
+    print_sample_estimate("CPI", cpi);
+    if (mean > half_width)
+        cout << "IPC: " << 1.0/mean << " [" << 1.0/(mean + half_width) << ", " << 1.0/(mean - half_width) << "]" << endl;
+    print_sample_estimate("Branch MPKI", branch_mpki);
+    for (uint32_t j=0; j<NUM_SIMPOINT_CACHES; j++) {
+        string name = string(simpoint_cache_name[j]) + " MPKI";
+        print_sample_estimate(name.c_str(), mpki[j]);
+    }
+
+    // windows needed for +-3% CPI at 99.7% confidence, with the coefficient of variation measured here
+    if ((num_windows > 1) && mean) {
+        double variation = (half_width / 1.96) * sqrt((double)num_windows) / mean;
+        cout << "Windows needed for +-3% CPI at 99.7% confidence: " << (uint64_t)ceil(pow(3.0 * variation / 0.03, 2)) << endl;
+    }
+}
+
+// configuration sweeps (-sweep LIST), every configuration runs in its own forked simulator since the cores and the
+// uncore are globals. all of them run at once off the same trace stream: the parent decompresses every trace once
+// into a SWEEP_TRACE_RING shared with the configurations, which decode and simulate it side by side.
+SWEEP_TRACE_RING *sweep_rings[NUM_CPUS];
+int32_t sweep_config = -1; // configuration this simulator runs, -1 outside a sweep
+
+// one configuration per line, the module and -config knobs it sets on top of the command line, '#' starts a comment
+vector <string> read_sweep(const char *list_name)
+{
+    vector <string> configs;
+    ifstream list(list_name);
+    if (!list.good()) {
+        cerr << "[SWEEP] " << __func__ << " cannot open " << list_name << endl;
+        assert(0);
+    }
+
+    string line;
+    while (getline(list, line)) {
+        line = line.substr(0, line.find('#'));
+
+        string knob;
+        istringstream fields(line);
+        if (!(fields >> knob))
+            continue;
+
+        configs.push_back(line);
+    }
+
+    if (configs.empty() || (configs.size() > SWEEP_MAX_CONFIGS)) {
+        cerr << "[SWEEP] " << __func__ << " " << list_name << " must list 1 to " << SWEEP_MAX_CONFIGS << " configurations" << endl;
+        assert(0);
+    }
+
+    return configs;
+}
+
+void apply_sweep_config(string &config, char **config_file)
+{
+    istringstream fields(config);
+    string knob, value;
+    while (fields >> knob) {
+        if (!(fields >> value)) {
+            cerr << "[SWEEP] " << __func__ << " " << knob << " has no value: " << config << endl;
+            assert(0);
+        }
+
+        knob = knob.substr(knob.find_first_not_of('-'));
+        if (knob == "config")
+            *config_file = strdup(value.c_str());
+        else if (knob == "branch_predictor")
+            select_module(MODULE_BRANCH_PREDICTOR, value.c_str());
+        else if (knob == "l1i_prefetcher")
+            select_module(MODULE_L1I_PREFETCHER, value.c_str());
+        else if (knob == "l1d_prefetcher")
+            select_module(MODULE_L1D_PREFETCHER, value.c_str());
+        else if (knob == "l2c_prefetcher")
+            select_module(MODULE_L2C_PREFETCHER, value.c_str());
+        else if (knob == "llc_prefetcher")
+            select_module(MODULE_LLC_PREFETCHER, value.c_str());
+        else if (knob == "llc_replacement")
+            select_module(MODULE_LLC_REPLACEMENT, value.c_str());
+        else {
+            cerr << "[SWEEP] " << __func__ << " a configuration only sets -config and the module knobs, not -" << knob << endl;
+            assert(0);
+        }
+    }
+}
+
+void print_sweep_stats(vector <string> &configs, vector <simpoint_result> &results)
+{
+    cout << endl << "Sweep Statistics" << endl;
+    for (uint32_t i=0; i<configs.size(); i++) {
+        cout << endl << "Config " << i << ":" << configs[i] << endl;
+        for (uint32_t cpu=0; cpu<NUM_CPUS; cpu++) {
+            simpoint_result &result = results[i*NUM_CPUS + cpu];
+            cout << "CPU " << cpu << " IPC: " << (1.0*result.instructions) / result.cycles;
+            cout << " branch MPKI: " << (1000.0*result.branch_mispredictions) / result.roi_instructions;
+            for (uint32_t j=0; j<NUM_SIMPOINT_CACHES; j++)
+                cout << " " << simpoint_cache_name[j] << " MPKI: " << (1000.0*result.miss[j]) / result.instructions;
+            cout << endl;
+        }
+    }
+}
+
+// forks every configuration, then decompresses the traces for them until they are all done
+// returns the configuration index in the child, which goes on to simulate it, and -1 in the parent
+int run_sweep(vector <string> &configs, int argc, char **argv, const char *list_name, int *result_fd)
+{
+    uint32_t num_configs = configs.size(),
+             instr_size = knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
+
+    // the traces follow -traces, one per core
+    TRACE_READER *readers[NUM_CPUS];
+    uint32_t num_traces = 0;
+    for (int i=0; i<argc; i++) {
+        if (strcmp(argv[i], "-traces") && strcmp(argv[i], "--traces"))
+            continue;
+
+        for (int j=i+1; (j<argc) && (num_traces<NUM_CPUS); j++) {
+            readers[num_traces] = open_trace_reader(argv[j]);
+            if (readers[num_traces] == NULL) {
+                cerr << "[SWEEP] " << __func__ << " cannot open trace " << argv[j] << endl;
+                assert(0);
+            }
+            if (skip_instructions && !readers[num_traces]->seek(skip_instructions, instr_size)) {
+                cerr << "[SWEEP] " << __func__ << " trace has fewer than " << skip_instructions << " instructions: " << argv[j] << endl;
+                assert(0);
+            }
+
+            sweep_rings[num_traces] = SWEEP_TRACE_RING::create(instr_size, num_configs);
+            num_traces++;
+        }
+        break;
+    }
+    if (num_traces != NUM_CPUS) {
+        cerr << "[SWEEP] " << __func__ << " needs " << NUM_CPUS << " traces, found " << num_traces << endl;
+        assert(0);
+    }
+
+    cout << "Sweep configurations: " << num_configs << endl;
+
+    vector <simpoint_result> results(num_configs * NUM_CPUS);
+    map <pid_t, pair <uint32_t, int> > running;
+    for (uint32_t config=0; config<num_configs; config++) {
+        int fd[2];
+        if (pipe(fd)) {
+            cerr << "[SWEEP] " << __func__ << " pipe failed" << endl;
+            assert(0);
+        }
+
+        // nothing buffered may be written twice
+        cout.flush();
+        fflush(stdout);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "[SWEEP] " << __func__ << " fork failed" << endl;
+            assert(0);
+        }
+        if (pid == 0) {
+            close(fd[0]);
+            *result_fd = fd[1];
+            sweep_config = config;
+
+            // the full report of every configuration goes next to the configuration list
+            string output_name = string(list_name) + ".config" + to_string(config) + ".txt";
+            if (freopen(output_name.c_str(), "w", stdout) == NULL) {
+                cerr << "[SWEEP] " << __func__ << " cannot open " << output_name << endl;
+                assert(0);
+            }
+
+            return config;
+        }
+
+        close(fd[1]);
+        cout << "Config " << config << ":" << configs[config] << endl;
+        running[pid] = make_pair(config, fd[0]);
+    }
+
+    // no threads before the last fork
+    vector <thread> producers;
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        producers.push_back(thread(&SWEEP_TRACE_RING::produce, sweep_rings[i], readers[i]));
+
+    uint32_t failed = 0;
+    while (!running.empty()) {
+        int status;
+        pid_t pid = wait(&status);
+        map <pid_t, pair <uint32_t, int> >::iterator job = running.find(pid);
+        if (job == running.end())
+            continue;
+
+        // a configuration that is gone no longer holds back the others
+        uint32_t config = job->second.first;
+        int fd = job->second.second;
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            sweep_rings[i]->consumed[config].store(UINT64_MAX);
+
+        uint64_t size = NUM_CPUS * sizeof(simpoint_result);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) || (read(fd, &results[config*NUM_CPUS], size) != (ssize_t)size)) {
+            cerr << "*** Config " << config << " (" << configs[config] << ") did not complete ***" << endl;
+            failed++;
+        }
+        close(fd);
+        running.erase(job);
+    }
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        sweep_rings[i]->stop();
+        producers[i].join();
+        delete readers[i];
+    }
+
+    if (failed) {
+        cerr << "[SWEEP] " << __func__ << " " << failed << " configuration(s) failed" << endl;
+        assert(0);
+    }
+
+    print_sweep_stats(configs, results);
+
+    return -1;
+}
+
 int main(int argc, char** argv)
 {
 	// interrupt signal hanlder
@@ -513,6 +1572,20 @@ int main(int argc, char** argv)
 
     uint32_t seed_number = 0;
 
+    char *config_file = NULL;
+
+    select_module(MODULE_BRANCH_PREDICTOR, DEFAULT_BRANCH_PREDICTOR);
+    select_module(MODULE_L1I_PREFETCHER, DEFAULT_L1I_PREFETCHER);
+    select_module(MODULE_L1D_PREFETCHER, DEFAULT_L1D_PREFETCHER);
+    select_module(MODULE_L2C_PREFETCHER, DEFAULT_L2C_PREFETCHER);
+    select_module(MODULE_LLC_PREFETCHER, DEFAULT_LLC_PREFETCHER);
+    select_module(MODULE_LLC_REPLACEMENT, DEFAULT_LLC_REPLACEMENT);
+
+    char *simpoint_list = NULL,
+         *sweep_list = NULL;
+    uint32_t simpoint_jobs = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+    int simpoint_fd = -1;
+
     // check to see if knobs changed using getopt_long()
     int c;
     while (1) {
@@ -520,9 +1593,29 @@ int main(int argc, char** argv)
         {
             {"warmup_instructions", required_argument, 0, 'w'},
             {"simulation_instructions", required_argument, 0, 'i'},
+            {"skip_instructions", required_argument, 0, 's'},
             {"hide_heartbeat", no_argument, 0, 'h'},
             {"cloudsuite", no_argument, 0, 'c'},
             {"low_bandwidth",  no_argument, 0, 'b'},
+            {"derived_cache",  no_argument, 0, 'd'},
+            {"config", required_argument, 0, 'f'},
+            {"branch_predictor", required_argument, 0, 'B'},
+            {"l1i_prefetcher", required_argument, 0, 'I'},
+            {"l1d_prefetcher", required_argument, 0, 'D'},
+            {"l2c_prefetcher", required_argument, 0, 'L'},
+            {"llc_prefetcher", required_argument, 0, 'P'},
+            {"llc_replacement", required_argument, 0, 'R'},
+            {"simpoints", required_argument, 0, 'p'},
+            {"jobs", required_argument, 0, 'j'},
+            {"quantum", required_argument, 0, 'q'},
+            {"save_checkpoint", required_argument, 0, 'k'},
+            {"restore_checkpoint", required_argument, 0, 'r'},
+            {"detailed_warmup_instructions", required_argument, 0, 'W'},
+            {"sampling_period", required_argument, 0, 'S'},
+            {"sampling_window", required_argument, 0, 'U'},
+            {"sampling_warmup", required_argument, 0, 'X'},
+            {"sweep", required_argument, 0, 'x'},
+            {"host_stats", no_argument, 0, 'H'},
             {"traces",  no_argument, 0, 't'},
             {0, 0, 0, 0}      
         };
@@ -544,6 +1637,9 @@ int main(int argc, char** argv)
             case 'i':
                 simulation_instructions = atol(optarg);
                 break;
+            case 's':
+                skip_instructions = atol(optarg);
+                break;
             case 'h':
                 show_heartbeat = 0;
                 break;
@@ -554,6 +1650,64 @@ int main(int argc, char** argv)
             case 'b':
                 knob_low_bandwidth = 1;
                 break;
+            case 'd':
+                knob_derived_cache = 1;
+                break;
+            case 'f':
+                config_file = optarg;
+                break;
+            case 'B':
+                select_module(MODULE_BRANCH_PREDICTOR, optarg);
+                break;
+            case 'I':
+                select_module(MODULE_L1I_PREFETCHER, optarg);
+                break;
+            case 'D':
+                select_module(MODULE_L1D_PREFETCHER, optarg);
+                break;
+            case 'L':
+                select_module(MODULE_L2C_PREFETCHER, optarg);
+                break;
+            case 'P':
+                select_module(MODULE_LLC_PREFETCHER, optarg);
+                break;
+            case 'R':
+                select_module(MODULE_LLC_REPLACEMENT, optarg);
+                break;
+            case 'p':
+                simpoint_list = optarg;
+                break;
+            case 'j':
+                simpoint_jobs = atoi(optarg) > 0 ? atoi(optarg) : 1;
+                break;
+            case 'q':
+                quantum_cycles = atol(optarg);
+                break;
+            case 'k':
+                save_checkpoint_file = optarg;
+                break;
+            case 'r':
+                restore_checkpoint_file = optarg;
+                break;
+            case 'W':
+                knob_functional_warmup = 1;
+                detailed_warmup_instructions = atol(optarg);
+                break;
+            case 'S':
+                sampling_period = atol(optarg);
+                break;
+            case 'U':
+                sampling_window = atol(optarg);
+                break;
+            case 'X':
+                sampling_warmup = atol(optarg);
+                break;
+            case 'x':
+                sweep_list = optarg;
+                break;
+            case 'H':
+                knob_host_stats = 1;
+                break;
             case 't':
                 traces_encountered = 1;
                 break;
@@ -565,11 +1719,127 @@ int main(int argc, char** argv)
             break;
     }
 
+    if (save_checkpoint_file && restore_checkpoint_file) {
+        cerr << "[CHECKPOINT] -save_checkpoint and -restore_checkpoint cannot be used together" << endl;
+        assert(0);
+    }
+    if ((save_checkpoint_file || restore_checkpoint_file) && simpoint_list) {
+        cerr << "[CHECKPOINT] checkpoints cannot be used with -simpoints" << endl;
+        assert(0);
+    }
+    if (sampling_period) {
+        if (NUM_CPUS != 1) {
+            cerr << "[SAMPLING] -sampling_period needs a single-core build, NUM_CPUS: " << NUM_CPUS << endl;
+            assert(0);
+        }
+        if (simpoint_list) {
+            cerr << "[SAMPLING] -sampling_period cannot be used with -simpoints" << endl;
+            assert(0);
+        }
+        if ((sampling_window == 0) || (sampling_period < sampling_warmup + sampling_window)) {
+            cerr << "[SAMPLING] the period: " << sampling_period << " must hold the detailed warmup: " << sampling_warmup << " and a window: " << sampling_window << endl;
+            assert(0);
+        }
+    }
+
+    if (sweep_list && (simpoint_list || save_checkpoint_file || restore_checkpoint_file)) {
+        cerr << "[SWEEP] -sweep cannot be used with -simpoints or checkpoints" << endl;
+        assert(0);
+    }
+
+    // every configuration of a sweep is simulated in a child and only the parent returns here
+    if (sweep_list) {
+        vector <string> configs = read_sweep(sweep_list);
+        int config = run_sweep(configs, argc, argv, sweep_list, &simpoint_fd);
+        if (config < 0)
+            return 0;
+
+        apply_sweep_config(configs[config], &config_file);
+    }
+
+    if (config_file)
+        load_config(config_file);
+
+    // a region list replaces -traces, every region is simulated in a child and only the parent returns here
+    char simpoint_traces_knob[] = "-traces";
+    char *simpoint_argv[2];
+    if (simpoint_list) {
+        if (NUM_CPUS != 1) {
+            cerr << "[SIMPOINT] -simpoints needs a single-core build, NUM_CPUS: " << NUM_CPUS << endl;
+            assert(0);
+        }
+
+        vector <simpoint_region> regions = read_simpoints(simpoint_list);
+        int region = run_simpoints(regions, simpoint_jobs, simpoint_list, &simpoint_fd);
+        if (region < 0)
+            return 0;
+
+        skip_instructions = regions[region].skip_instructions;
+        simpoint_argv[0] = simpoint_traces_knob;
+        simpoint_argv[1] = strdup(regions[region].trace.c_str());
+        argc = 2;
+        argv = simpoint_argv;
+    }
+
+    // the cores and the uncore are sized by the config, so they are only built once it is read
+    ooo_cpu = new O3_CPU[NUM_CPUS];
+    uncore = new UNCORE;
+
+    // the header tells where every trace resumes, the rest is applied once everything is initialized
+    if (restore_checkpoint_file) {
+        restored_checkpoint = new CHECKPOINT(1);
+        restored_checkpoint->read_file(restore_checkpoint_file);
+        transfer_checkpoint_header(*restored_checkpoint);
+    }
+
     // consequences of knobs
     cout << "Warmup Instructions: " << warmup_instructions << endl;
     cout << "Simulation Instructions: " << simulation_instructions << endl;
+    cout << "Branch Predictor: " << selected_module_name(MODULE_BRANCH_PREDICTOR) << endl;
+    cout << "L1I Prefetcher: " << selected_module_name(MODULE_L1I_PREFETCHER) << endl;
+    cout << "L1D Prefetcher: " << selected_module_name(MODULE_L1D_PREFETCHER) << endl;
+    cout << "L2C Prefetcher: " << selected_module_name(MODULE_L2C_PREFETCHER) << endl;
+    cout << "LLC Prefetcher: " << selected_module_name(MODULE_LLC_PREFETCHER) << endl;
+    cout << "LLC Replacement: " << selected_module_name(MODULE_LLC_REPLACEMENT) << endl;
+    if (skip_instructions && restore_checkpoint_file) {
+        cout << "Skip Instructions is ignored, the checkpoint holds the trace positions" << endl;
+        skip_instructions = 0;
+    }
+    if (skip_instructions)
+        cout << "Skip Instructions: " << skip_instructions << endl;
+    if (sampling_period)
+        cout << "Sampling Period: " << sampling_period << " Window: " << sampling_window << " Detailed Warmup: " << sampling_warmup << endl;
+    if (save_checkpoint_file)
+        cout << "Save Checkpoint: " << save_checkpoint_file << endl;
+    if (restore_checkpoint_file)
+        cout << "Restore Checkpoint: " << restore_checkpoint_file << endl;
+    if (knob_functional_warmup && restore_checkpoint_file) {
+        cout << "Detailed Warmup Instructions is ignored, the checkpoint holds the warmed up state" << endl;
+        knob_functional_warmup = 0;
+    }
+    if (knob_functional_warmup && (detailed_warmup_instructions >= warmup_instructions)) {
+        cout << "Detailed Warmup Instructions covers the whole warmup, no functional warmup" << endl;
+        knob_functional_warmup = 0;
+    }
+    if (knob_functional_warmup)
+        cout << "Functional Warmup Instructions: " << warmup_instructions - detailed_warmup_instructions << " Detailed Warmup Instructions: " << detailed_warmup_instructions << endl;
+    if (knob_derived_cache && knob_cloudsuite) {
+        cout << "Derived cache is not used for cloudsuite traces" << endl;
+        knob_derived_cache = 0;
+    }
     //cout << "Scramble Loads: " << (knob_scramble_loads ? "ture" : "false") << endl;
     cout << "Number of CPUs: " << NUM_CPUS << endl;
+    if (quantum_cycles && (NUM_CPUS == 1)) {
+        cout << "Quantum is ignored on a single core" << endl;
+        quantum_cycles = 0;
+    }
+    // with fewer host CPUs than cores, the core threads only get in each other's way
+    if (quantum_cycles && thread::hardware_concurrency() && (NUM_CPUS > thread::hardware_concurrency())) {
+        cout << "Quantum is ignored with " << NUM_CPUS << " cores on " << thread::hardware_concurrency() << " host CPUs, the cores run serially" << endl;
+        quantum_cycles = 0;
+    }
+    if (quantum_cycles)
+        cout << "Parallel cores, quantum: " << quantum_cycles << " cycles" << endl;
     cout << "LLC sets: " << LLC_SET << endl;
     cout << "LLC ways: " << LLC_WAY << endl;
 
@@ -588,14 +1858,15 @@ int main(int argc, char** argv)
     // note that dram burst length = BLOCK_SIZE/DRAM_CHANNEL_WIDTH
     DRAM_DBUS_RETURN_TIME = (BLOCK_SIZE / DRAM_CHANNEL_WIDTH) * (CPU_FREQ / DRAM_MTPS);
 
-    printf("Off-chip DRAM Size: %u MB Channels: %u Width: %u-bit Data Rate: %u MT/s\n",
-            DRAM_SIZE, DRAM_CHANNELS, 8*DRAM_CHANNEL_WIDTH, DRAM_MTPS);
+    printf("Off-chip DRAM Size: %lu MB Channels: %u Width: %u-bit Data Rate: %u MT/s\n",
+            (unsigned long)DRAM_SIZE, DRAM_CHANNELS, 8*DRAM_CHANNEL_WIDTH, DRAM_MTPS);
 
     // end consequence of knobs
 
     // search through the argv for "-traces"
     int found_traces = 0;
     int count_traces = 0;
+    map <string, shared_ptr <SHARED_TRACE_SOURCE> > shared_traces;
     cout << endl;
     for (int i=0; i<argc; i++) {
         if (found_traces)
@@ -605,10 +1876,19 @@ int main(int argc, char** argv)
             sprintf(ooo_cpu[count_traces].trace_string, "%s", argv[i]);
 
             std::string full_name(argv[i]);
-            std::string last_dot = full_name.substr(full_name.find_last_of("."));
 
-            std::string fmtstr;
-            std::string decomp_program;
+            // a restored core resumes where its trace was when the checkpoint was saved
+            uint64_t first_record = skip_instructions;
+            if (restore_checkpoint_file && (count_traces < NUM_CPUS)) {
+                checkpoint_core &core = checkpoint_cores[count_traces];
+                if (trace_basename(core.trace) != trace_basename(full_name)) {
+                    std::cerr << "*** Checkpoint of CPU " << count_traces << " was saved with another trace: " << core.trace << " ***" << std::endl;
+                    assert(0);
+                }
+                first_record = core.record;
+                ooo_cpu[count_traces].trace_first_instr_id = core.retired;
+            }
+            ooo_cpu[count_traces].trace_first_record = first_record;
             if (full_name.substr(0,4) == "http")
             {
                 // Check file exists
@@ -620,7 +1900,6 @@ int main(int argc, char** argv)
                     std::cerr << "TRACE FILE NOT FOUND" << std::endl;
                     assert(0);
                 }
-                fmtstr = "wget -qO- %2$s | %1$s -dc";
             }
             else
             {
@@ -630,19 +1909,66 @@ int main(int argc, char** argv)
                     std::cerr << "TRACE FILE NOT FOUND" << std::endl;
                     assert(0);
                 }
-                fmtstr = "%1$s -dc %2$s";
             }
 
-            if (last_dot[1] == 'g') // gzip format
-                decomp_program = "gzip";
-            else if (last_dot[1] == 'x') // xz
-                decomp_program = "xz";
+            // gz, xz and chunked traces are decompressed in-process
+            uint32_t instr_size = knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
+            TRACE_READER *trace_reader;
+            map <string, shared_ptr <SHARED_TRACE_SOURCE> >::iterator shared_trace = shared_traces.find(full_name);
+            if (sweep_config >= 0) {
+                // the sweep parent decompresses the trace and has already skipped to the first record
+                trace_reader = new SWEEP_TRACE_READER(sweep_rings[count_traces], sweep_config, full_name);
+            }
+            else if (shared_trace != shared_traces.end()) {
+                // an earlier core already opened this trace, only add a cursor to it
+                trace_reader = new SHARED_TRACE_READER(shared_trace->second);
+            }
             else {
-                std::cout << "ChampSim does not support traces other than gz or xz compression!" << std::endl;
-                assert(0);
+                trace_reader = open_trace_reader(argv[i]);
+                if (trace_reader == NULL) {
+                    std::cout << "ChampSim does not support traces other than gz, xz, chunked (.cct) or uncompressed (.raw) traces!" << std::endl;
+                    assert(0);
+                }
+
+                if (trace_reader->format_record_size && (trace_reader->format_record_size != instr_size)) {
+                    std::cerr << "*** Trace record size " << trace_reader->format_record_size << " does not match the instruction format size " << instr_size << " ***" << std::endl;
+                    assert(0);
+                }
+
+                // fast-forward, chunked traces seek straight to the chunk holding the first simulated instruction
+                if (first_record && !trace_reader->seek(first_record, instr_size)) {
+                    std::cerr << "*** Trace has fewer than " << first_record << " instructions: " << argv[i] << " ***" << std::endl;
+                    assert(0);
+                }
+
+                // cores running the same trace share a single decompressor, each one reads through its own cursor,
+                // restored cores resume at different positions and open their own
+                uint32_t num_readers = 1;
+                for (int k=i+1; (k<argc) && (restore_checkpoint_file == NULL); k++)
+                    if (full_name == argv[k])
+                        num_readers++;
+
+                if (num_readers > 1) {
+                    shared_traces[full_name] = make_shared<SHARED_TRACE_SOURCE>(trace_reader, instr_size, num_readers, first_record);
+                    trace_reader = new SHARED_TRACE_READER(shared_traces[full_name]);
+                }
             }
+            // branch classification and branch targets from the sidecar built by scripts/build_derived_cache.cc
+            TRACE_READER *derived_reader = NULL;
+            if (knob_derived_cache) {
+                string derived_name = full_name + ".derived.raw";
+                if (!std::ifstream(derived_name.c_str()).good()) {
+                    std::cerr << "*** Derived cache not found: " << derived_name << " ***" << std::endl;
+                    assert(0);
+                }
 
-            sprintf(ooo_cpu[count_traces].gunzip_command, fmtstr.c_str(), decomp_program.c_str(), argv[i]);
+                derived_reader = open_trace_reader(derived_name.c_str());
+                if (first_record && !derived_reader->seek(first_record, sizeof(derived_instr))) {
+                    std::cerr << "*** Derived cache has fewer than " << first_record << " entries: " << derived_name << " ***" << std::endl;
+                    assert(0);
+                }
+            }
+            ooo_cpu[count_traces].trace_decoder = new TRACE_DECODER(trace_reader, derived_reader);
 
             char *pch[100];
             int count_str = 0;
@@ -663,12 +1989,6 @@ int main(int argc, char** argv)
                 j++;
             }
 
-            ooo_cpu[count_traces].trace_file = popen(ooo_cpu[count_traces].gunzip_command, "r");
-            if (ooo_cpu[count_traces].trace_file == NULL) {
-                printf("\n*** Trace file not found: %s ***\n\n", argv[i]);
-                assert(0);
-            }
-
             count_traces++;
             if (count_traces > NUM_CPUS) {
                 printf("\n*** Too many traces for the configured number of cores ***\n\n");
@@ -749,24 +2069,24 @@ int main(int argc, char** argv)
         ooo_cpu[i].L2C.fill_level = FILL_L2;
         ooo_cpu[i].L2C.upper_level_icache[i] = &ooo_cpu[i].L1I;
         ooo_cpu[i].L2C.upper_level_dcache[i] = &ooo_cpu[i].L1D;
-        ooo_cpu[i].L2C.lower_level = &uncore.LLC;
+        ooo_cpu[i].L2C.lower_level = &uncore->LLC;
         ooo_cpu[i].L2C.l2c_prefetcher_initialize();
 
         // SHARED CACHE
-        uncore.LLC.cache_type = IS_LLC;
-        uncore.LLC.fill_level = FILL_LLC;
-        uncore.LLC.MAX_READ = NUM_CPUS;
-        uncore.LLC.upper_level_icache[i] = &ooo_cpu[i].L2C;
-        uncore.LLC.upper_level_dcache[i] = &ooo_cpu[i].L2C;
-        uncore.LLC.lower_level = &uncore.DRAM;
+        uncore->LLC.cache_type = IS_LLC;
+        uncore->LLC.fill_level = FILL_LLC;
+        uncore->LLC.MAX_READ = NUM_CPUS;
+        uncore->LLC.upper_level_icache[i] = &ooo_cpu[i].L2C;
+        uncore->LLC.upper_level_dcache[i] = &ooo_cpu[i].L2C;
+        uncore->LLC.lower_level = &uncore->DRAM;
 
         // OFF-CHIP DRAM
-        uncore.DRAM.fill_level = FILL_DRAM;
-        uncore.DRAM.upper_level_icache[i] = &uncore.LLC;
-        uncore.DRAM.upper_level_dcache[i] = &uncore.LLC;
+        uncore->DRAM.fill_level = FILL_DRAM;
+        uncore->DRAM.upper_level_icache[i] = &uncore->LLC;
+        uncore->DRAM.upper_level_dcache[i] = &uncore->LLC;
         for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
-            uncore.DRAM.RQ[i].is_RQ = 1;
-            uncore.DRAM.WQ[i].is_WQ = 1;
+            uncore->DRAM.RQ[i].is_RQ = 1;
+            uncore->DRAM.WQ[i].is_WQ = 1;
         }
 
         warmup_complete[i] = 0;
@@ -784,89 +2104,31 @@ int main(int argc, char** argv)
         major_fault[i] = 0;
     }
 
-    uncore.LLC.llc_initialize_replacement();
-    uncore.LLC.llc_prefetcher_initialize();
+    uncore->LLC.llc_initialize_replacement();
+    uncore->LLC.llc_prefetcher_initialize();
+
+    if (restore_checkpoint_file)
+        restore_checkpoint();
+
+    // start decoding traces in the background
+    for (int i=0; i<NUM_CPUS; i++)
+        ooo_cpu[i].trace_decoder->start();
 
     // simulation entry point
     start_time = time(NULL);
-    uint8_t run_simulation = 1;
+    start_host_stats();
+    if (knob_functional_warmup)
+        run_functional_warmup();
+    if (quantum_cycles)
+        run_parallel_simulation(show_heartbeat);
+    uint8_t run_simulation = !quantum_cycles;
     while (run_simulation) {
 
-        uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
-                 elapsed_minute = elapsed_second / 60,
-                 elapsed_hour = elapsed_minute / 60;
-        elapsed_minute -= elapsed_hour*60;
-        elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
-
         for (int i=0; i<NUM_CPUS; i++) {
             // proceed one cycle
             current_core_cycle[i]++;
 
-            //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
-            //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
-
-            // core might be stalled due to page fault or branch misprediction
-            if (stall_cycle[i] <= current_core_cycle[i]) {
-
-	      // retire
-	      if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
-		ooo_cpu[i].retire_rob();
-
-	      // complete 
-	      ooo_cpu[i].update_rob();
-
-	      // schedule
-	      uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
-	      if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
-		ooo_cpu[i].schedule_instruction();
-	      // execute
-	      ooo_cpu[i].execute_instruction();
-
-	      ooo_cpu[i].update_rob();
-
-	      // memory operation
-	      ooo_cpu[i].schedule_memory_instruction();
-	      ooo_cpu[i].execute_memory_instruction();
-
-	      ooo_cpu[i].update_rob();
-
-	      // decode
-	      if(ooo_cpu[i].DECODE_BUFFER.occupancy > 0)
-		{
-		  ooo_cpu[i].decode_and_dispatch();
-		}
-	      
-	      // fetch
-	      ooo_cpu[i].fetch_instruction();
-	      
-	      // read from trace
-	      if ((ooo_cpu[i].IFETCH_BUFFER.occupancy < ooo_cpu[i].IFETCH_BUFFER.SIZE) && (ooo_cpu[i].fetch_stall == 0))
-		{
-		  ooo_cpu[i].read_from_trace();
-		}
-	    }
-
-            // heartbeat information
-            if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction)) {
-                float cumulative_ipc;
-                if (warmup_complete[i])
-                    cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
-                else
-                    cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
-                float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
-
-                cout << "Heartbeat CPU " << i << " instructions: " << ooo_cpu[i].num_retired << " cycles: " << current_core_cycle[i];
-                cout << " heartbeat IPC: " << heartbeat_ipc << " cumulative IPC: " << cumulative_ipc; 
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-                ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
-
-                ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
-                ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
-            }
-
-            // check for deadlock
-            if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
-                print_deadlock(i);
+            operate_cpu(i, show_heartbeat, cout);
 
             // check for warmup
             // warmup complete
@@ -889,20 +2151,12 @@ int main(int argc, char** argv)
             */
             
             // simulation complete
-            if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions))) {
-                simulation_complete[i] = 1;
-                ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
-                ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
-
-                cout << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
-                cout << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-
-                record_roi_stats(i, &ooo_cpu[i].L1D);
-                record_roi_stats(i, &ooo_cpu[i].L1I);
-                record_roi_stats(i, &ooo_cpu[i].L2C);
-                record_roi_stats(i, &uncore.LLC);
-
+            if (sampling_period) {
+                if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && operate_sampling(cout))
+                    all_simulation_complete++;
+            }
+            else if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions))) {
+                finish_cpu_simulation(i, cout);
                 all_simulation_complete++;
             }
 
@@ -911,8 +2165,11 @@ int main(int argc, char** argv)
         }
 
         // TODO: should it be backward?
-        uncore.DRAM.operate();
-        uncore.LLC.operate();
+        uncore->DRAM.operate();
+        uncore->LLC.operate();
+
+        if (sample_drain_pending() == 0)
+            skip_idle_cycles();
     }
 
     uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
@@ -935,9 +2192,9 @@ int main(int argc, char** argv)
             ooo_cpu[i].L1D.l1d_prefetcher_final_stats();
 	    ooo_cpu[i].L2C.l2c_prefetcher_final_stats();
 #endif
-            print_sim_stats(i, &uncore.LLC);
+            print_sim_stats(i, &uncore->LLC);
         }
-        uncore.LLC.llc_prefetcher_final_stats();
+        uncore->LLC.llc_prefetcher_final_stats();
     }
 
     cout << endl << "Region of Interest Statistics" << endl;
@@ -949,7 +2206,7 @@ int main(int argc, char** argv)
         print_roi_stats(i, &ooo_cpu[i].L1I);
         print_roi_stats(i, &ooo_cpu[i].L2C);
 #endif
-        print_roi_stats(i, &uncore.LLC);
+        print_roi_stats(i, &uncore->LLC);
         cout << "Major fault: " << major_fault[i] << " Minor fault: " << minor_fault[i] << endl;
     }
 
@@ -959,13 +2216,35 @@ int main(int argc, char** argv)
         ooo_cpu[i].L2C.l2c_prefetcher_final_stats();
     }
 
-    uncore.LLC.llc_prefetcher_final_stats();
+    uncore->LLC.llc_prefetcher_final_stats();
 
 #ifndef CRC2_COMPILE
-    uncore.LLC.llc_replacement_final_stats();
+    uncore->LLC.llc_replacement_final_stats();
     print_dram_stats();
     print_branch_stats();
 #endif
 
+    if (sampling_period)
+        print_sampling_stats();
+
+    if (knob_host_stats)
+        print_host_stats();
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        ooo_cpu[i].trace_decoder->stop();
+
+    // hand the region statistics to the simpoint or sweep parent
+    if (simpoint_fd >= 0) {
+        simpoint_result result[NUM_CPUS];
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            collect_simpoint_result(i, &result[i]);
+        cout.flush();
+        if (write(simpoint_fd, result, sizeof(result)) != sizeof(result)) {
+            cerr << "[SIMPOINT] cannot send the region statistics" << endl;
+            assert(0);
+        }
+        close(simpoint_fd);
+    }
+
     return 0;
 }
@@ -0,0 +1,372 @@
+#include "ooo_cpu.h"
+
+uint32_t selected_module[NUM_MODULE_KINDS];
+
+#define MODULE_NAME(name) #name,
+
+static const char *branch_predictor_names[] = { BRANCH_PREDICTORS(MODULE_NAME) },
+                  *l1i_prefetcher_names[] = { L1I_PREFETCHERS(MODULE_NAME) },
+                  *l1d_prefetcher_names[] = { L1D_PREFETCHERS(MODULE_NAME) },
+                  *l2c_prefetcher_names[] = { L2C_PREFETCHERS(MODULE_NAME) },
+                  *llc_prefetcher_names[] = { LLC_PREFETCHERS(MODULE_NAME) },
+                  *llc_replacement_names[] = { LLC_REPLACEMENTS(MODULE_NAME) };
+
+class module_kind {
+  public:
+    const char *knob, *extension;
+    const char **names;
+    uint32_t num_modules;
+};
+
+static const module_kind module_kinds[NUM_MODULE_KINDS] = {
+    { "branch_predictor", "bpred", branch_predictor_names, NUM_BRANCH_PREDICTORS },
+    { "l1i_prefetcher", "l1i_pref", l1i_prefetcher_names, NUM_L1I_PREFETCHERS },
+    { "l1d_prefetcher", "l1d_pref", l1d_prefetcher_names, NUM_L1D_PREFETCHERS },
+    { "l2c_prefetcher", "l2c_pref", l2c_prefetcher_names, NUM_L2C_PREFETCHERS },
+    { "llc_prefetcher", "llc_pref", llc_prefetcher_names, NUM_LLC_PREFETCHERS },
+    { "llc_replacement", "llc_repl", llc_replacement_names, NUM_LLC_REPLACEMENTS }
+};
+
+void select_module(uint32_t kind, const char *name)
+{
+    const module_kind &modules = module_kinds[kind];
+    for (uint32_t i=0; i<modules.num_modules; i++) {
+        if (strcmp(name, modules.names[i]) == 0) {
+            selected_module[kind] = i;
+            return;
+        }
+    }
+
+    cerr << "[MODULE] " << __func__ << " unknown " << modules.knob << ": " << name << endl;
+    cerr << "[MODULE] possible " << modules.knob << "s from *." << modules.extension << ":";
+    for (uint32_t i=0; i<modules.num_modules; i++)
+        cerr << " " << modules.names[i];
+    cerr << endl;
+    assert(0);
+}
+
+const char *selected_module_name(uint32_t kind)
+{
+    return module_kinds[kind].names[selected_module[kind]];
+}
+
+// dispatch, one case per module
+#define CALL_MODULE(id, function, ...) case id: function(__VA_ARGS__); break;
+#define RETURN_MODULE(id, function, ...) case id: return function(__VA_ARGS__);
+
+// branch predictor
+#define INITIALIZE_BRANCH_PREDICTOR(name) CALL_MODULE(BRANCH_PREDICTOR_##name, initialize_branch_predictor_##name)
+#define PREDICT_BRANCH(name) RETURN_MODULE(BRANCH_PREDICTOR_##name, predict_branch_##name, ip)
+#define LAST_BRANCH_RESULT(name) CALL_MODULE(BRANCH_PREDICTOR_##name, last_branch_result_##name, ip, taken)
+
+void O3_CPU::initialize_branch_predictor()
+{
+    switch (selected_module[MODULE_BRANCH_PREDICTOR]) {
+        BRANCH_PREDICTORS(INITIALIZE_BRANCH_PREDICTOR)
+    }
+}
+
+uint8_t O3_CPU::predict_branch(uint64_t ip)
+{
+    switch (selected_module[MODULE_BRANCH_PREDICTOR]) {
+        BRANCH_PREDICTORS(PREDICT_BRANCH)
+    }
+    assert(0);
+    return 0;
+}
+
+void O3_CPU::last_branch_result(uint64_t ip, uint8_t taken)
+{
+    switch (selected_module[MODULE_BRANCH_PREDICTOR]) {
+        BRANCH_PREDICTORS(LAST_BRANCH_RESULT)
+    }
+}
+
+// L1I prefetcher
+#define L1I_PREFETCHER_INITIALIZE(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_initialize_##name)
+#define L1I_PREFETCHER_BRANCH_OPERATE(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_branch_operate_##name, ip, branch_type, branch_target)
+#define L1I_PREFETCHER_CACHE_OPERATE(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_cache_operate_##name, v_addr, cache_hit, prefetch_hit)
+#define L1I_PREFETCHER_CYCLE_OPERATE(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_cycle_operate_##name)
+#define L1I_PREFETCHER_CYCLE_IDLE(name) RETURN_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_cycle_idle_##name)
+#define L1I_PREFETCHER_CACHE_FILL(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_cache_fill_##name, v_addr, set, way, prefetch, evicted_v_addr)
+#define L1I_PREFETCHER_FINAL_STATS(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_final_stats_##name)
+
+void O3_CPU::l1i_prefetcher_initialize()
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_INITIALIZE)
+    }
+}
+
+void O3_CPU::l1i_prefetcher_branch_operate(uint64_t ip, uint8_t branch_type, uint64_t branch_target)
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_BRANCH_OPERATE)
+    }
+}
+
+void O3_CPU::l1i_prefetcher_cache_operate(uint64_t v_addr, uint8_t cache_hit, uint8_t prefetch_hit)
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_CACHE_OPERATE)
+    }
+}
+
+void O3_CPU::l1i_prefetcher_cycle_operate()
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_CYCLE_OPERATE)
+    }
+}
+
+// optional: a module that does not define it may have work every cycle, the core is then never skipped ahead
+#define NO_L1I_PREFETCHER_CYCLE_IDLE(name) \
+    __attribute__((weak)) uint8_t O3_CPU::l1i_prefetcher_cycle_idle_##name() { return 0; }
+
+L1I_PREFETCHERS(NO_L1I_PREFETCHER_CYCLE_IDLE)
+
+uint8_t O3_CPU::l1i_prefetcher_cycle_idle()
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_CYCLE_IDLE)
+    }
+    assert(0);
+    return 0;
+}
+
+void O3_CPU::l1i_prefetcher_cache_fill(uint64_t v_addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_v_addr)
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_CACHE_FILL)
+    }
+}
+
+void O3_CPU::l1i_prefetcher_final_stats()
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_FINAL_STATS)
+    }
+}
+
+// L1D prefetcher
+#define L1D_PREFETCHER_INITIALIZE(name) CALL_MODULE(L1D_PREFETCHER_##name, l1d_prefetcher_initialize_##name)
+#define L1D_PREFETCHER_OPERATE(name) CALL_MODULE(L1D_PREFETCHER_##name, l1d_prefetcher_operate_##name, addr, ip, cache_hit, type)
+#define L1D_PREFETCHER_CACHE_FILL(name) CALL_MODULE(L1D_PREFETCHER_##name, l1d_prefetcher_cache_fill_##name, addr, set, way, prefetch, evicted_addr, metadata_in)
+#define L1D_PREFETCHER_FINAL_STATS(name) CALL_MODULE(L1D_PREFETCHER_##name, l1d_prefetcher_final_stats_##name)
+
+void CACHE::l1d_prefetcher_initialize()
+{
+    switch (selected_module[MODULE_L1D_PREFETCHER]) {
+        L1D_PREFETCHERS(L1D_PREFETCHER_INITIALIZE)
+    }
+}
+
+void CACHE::l1d_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type)
+{
+    switch (selected_module[MODULE_L1D_PREFETCHER]) {
+        L1D_PREFETCHERS(L1D_PREFETCHER_OPERATE)
+    }
+}
+
+void CACHE::l1d_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in)
+{
+    switch (selected_module[MODULE_L1D_PREFETCHER]) {
+        L1D_PREFETCHERS(L1D_PREFETCHER_CACHE_FILL)
+    }
+}
+
+void CACHE::l1d_prefetcher_final_stats()
+{
+    switch (selected_module[MODULE_L1D_PREFETCHER]) {
+        L1D_PREFETCHERS(L1D_PREFETCHER_FINAL_STATS)
+    }
+}
+
+// L2C prefetcher
+#define L2C_PREFETCHER_INITIALIZE(name) CALL_MODULE(L2C_PREFETCHER_##name, l2c_prefetcher_initialize_##name)
+#define L2C_PREFETCHER_OPERATE(name) RETURN_MODULE(L2C_PREFETCHER_##name, l2c_prefetcher_operate_##name, addr, ip, cache_hit, type, metadata_in)
+#define L2C_PREFETCHER_CACHE_FILL(name) RETURN_MODULE(L2C_PREFETCHER_##name, l2c_prefetcher_cache_fill_##name, addr, set, way, prefetch, evicted_addr, metadata_in)
+#define L2C_PREFETCHER_FINAL_STATS(name) CALL_MODULE(L2C_PREFETCHER_##name, l2c_prefetcher_final_stats_##name)
+
+void CACHE::l2c_prefetcher_initialize()
+{
+    switch (selected_module[MODULE_L2C_PREFETCHER]) {
+        L2C_PREFETCHERS(L2C_PREFETCHER_INITIALIZE)
+    }
+}
+
+uint32_t CACHE::l2c_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in)
+{
+    switch (selected_module[MODULE_L2C_PREFETCHER]) {
+        L2C_PREFETCHERS(L2C_PREFETCHER_OPERATE)
+    }
+    assert(0);
+    return 0;
+}
+
+uint32_t CACHE::l2c_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in)
+{
+    switch (selected_module[MODULE_L2C_PREFETCHER]) {
+        L2C_PREFETCHERS(L2C_PREFETCHER_CACHE_FILL)
+    }
+    assert(0);
+    return 0;
+}
+
+void CACHE::l2c_prefetcher_final_stats()
+{
+    switch (selected_module[MODULE_L2C_PREFETCHER]) {
+        L2C_PREFETCHERS(L2C_PREFETCHER_FINAL_STATS)
+    }
+}
+
+// LLC prefetcher
+#define LLC_PREFETCHER_INITIALIZE(name) CALL_MODULE(LLC_PREFETCHER_##name, llc_prefetcher_initialize_##name)
+#define LLC_PREFETCHER_OPERATE(name) RETURN_MODULE(LLC_PREFETCHER_##name, llc_prefetcher_operate_##name, addr, ip, cache_hit, type, metadata_in)
+#define LLC_PREFETCHER_CACHE_FILL(name) RETURN_MODULE(LLC_PREFETCHER_##name, llc_prefetcher_cache_fill_##name, addr, set, way, prefetch, evicted_addr, metadata_in)
+#define LLC_PREFETCHER_FINAL_STATS(name) CALL_MODULE(LLC_PREFETCHER_##name, llc_prefetcher_final_stats_##name)
+
+void CACHE::llc_prefetcher_initialize()
+{
+    switch (selected_module[MODULE_LLC_PREFETCHER]) {
+        LLC_PREFETCHERS(LLC_PREFETCHER_INITIALIZE)
+    }
+}
+
+uint32_t CACHE::llc_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in)
+{
+    switch (selected_module[MODULE_LLC_PREFETCHER]) {
+        LLC_PREFETCHERS(LLC_PREFETCHER_OPERATE)
+    }
+    assert(0);
+    return 0;
+}
+
+uint32_t CACHE::llc_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in)
+{
+    switch (selected_module[MODULE_LLC_PREFETCHER]) {
+        LLC_PREFETCHERS(LLC_PREFETCHER_CACHE_FILL)
+    }
+    assert(0);
+    return 0;
+}
+
+void CACHE::llc_prefetcher_final_stats()
+{
+    switch (selected_module[MODULE_LLC_PREFETCHER]) {
+        LLC_PREFETCHERS(LLC_PREFETCHER_FINAL_STATS)
+    }
+}
+
+// LLC replacement
+#define LLC_INITIALIZE_REPLACEMENT(name) CALL_MODULE(LLC_REPLACEMENT_##name, llc_initialize_replacement_##name)
+#define LLC_FIND_VICTIM(name) RETURN_MODULE(LLC_REPLACEMENT_##name, llc_find_victim_##name, cpu, instr_id, set, current_set, ip, full_addr, type)
+#define LLC_UPDATE_REPLACEMENT_STATE(name) CALL_MODULE(LLC_REPLACEMENT_##name, llc_update_replacement_state_##name, cpu, set, way, full_addr, ip, victim_addr, type, hit)
+#define LLC_REPLACEMENT_FINAL_STATS(name) CALL_MODULE(LLC_REPLACEMENT_##name, llc_replacement_final_stats_##name)
+
+void CACHE::llc_initialize_replacement()
+{
+    switch (selected_module[MODULE_LLC_REPLACEMENT]) {
+        LLC_REPLACEMENTS(LLC_INITIALIZE_REPLACEMENT)
+    }
+}
+
+uint32_t CACHE::llc_find_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+    switch (selected_module[MODULE_LLC_REPLACEMENT]) {
+        LLC_REPLACEMENTS(LLC_FIND_VICTIM)
+    }
+    assert(0);
+    return 0;
+}
+
+void CACHE::llc_update_replacement_state(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit)
+{
+    switch (selected_module[MODULE_LLC_REPLACEMENT]) {
+        LLC_REPLACEMENTS(LLC_UPDATE_REPLACEMENT_STATE)
+    }
+}
+
+void CACHE::llc_replacement_final_stats()
+{
+    switch (selected_module[MODULE_LLC_REPLACEMENT]) {
+        LLC_REPLACEMENTS(LLC_REPLACEMENT_FINAL_STATS)
+    }
+}
+
+// checkpoint, optional: the Makefile only renames the entry point when the module defines it,
+// otherwise the weak version below stops a run that saves or restores a checkpoint
+static void no_checkpoint(uint32_t kind)
+{
+    cerr << "[CHECKPOINT] " << module_kinds[kind].knob << " " << selected_module_name(kind) << " has no checkpoint support" << endl;
+    assert(0);
+}
+
+#define NO_BRANCH_PREDICTOR_CHECKPOINT(name) \
+    __attribute__((weak)) void O3_CPU::checkpoint_branch_predictor_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_BRANCH_PREDICTOR); }
+#define NO_L1I_PREFETCHER_CHECKPOINT(name) \
+    __attribute__((weak)) void O3_CPU::l1i_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_L1I_PREFETCHER); }
+#define NO_L1D_PREFETCHER_CHECKPOINT(name) \
+    __attribute__((weak)) void CACHE::l1d_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_L1D_PREFETCHER); }
+#define NO_L2C_PREFETCHER_CHECKPOINT(name) \
+    __attribute__((weak)) void CACHE::l2c_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_L2C_PREFETCHER); }
+#define NO_LLC_PREFETCHER_CHECKPOINT(name) \
+    __attribute__((weak)) void CACHE::llc_prefetcher_checkpoint_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_LLC_PREFETCHER); }
+#define NO_LLC_REPLACEMENT_CHECKPOINT(name) \
+    __attribute__((weak)) void CACHE::llc_replacement_checkpoint_##name(CHECKPOINT &checkpoint) { no_checkpoint(MODULE_LLC_REPLACEMENT); }
+
+BRANCH_PREDICTORS(NO_BRANCH_PREDICTOR_CHECKPOINT)
+L1I_PREFETCHERS(NO_L1I_PREFETCHER_CHECKPOINT)
+L1D_PREFETCHERS(NO_L1D_PREFETCHER_CHECKPOINT)
+L2C_PREFETCHERS(NO_L2C_PREFETCHER_CHECKPOINT)
+LLC_PREFETCHERS(NO_LLC_PREFETCHER_CHECKPOINT)
+LLC_REPLACEMENTS(NO_LLC_REPLACEMENT_CHECKPOINT)
+
+#define CHECKPOINT_BRANCH_PREDICTOR(name) CALL_MODULE(BRANCH_PREDICTOR_##name, checkpoint_branch_predictor_##name, checkpoint)
+#define L1I_PREFETCHER_CHECKPOINT(name) CALL_MODULE(L1I_PREFETCHER_##name, l1i_prefetcher_checkpoint_##name, checkpoint)
+#define L1D_PREFETCHER_CHECKPOINT(name) CALL_MODULE(L1D_PREFETCHER_##name, l1d_prefetcher_checkpoint_##name, checkpoint)
+#define L2C_PREFETCHER_CHECKPOINT(name) CALL_MODULE(L2C_PREFETCHER_##name, l2c_prefetcher_checkpoint_##name, checkpoint)
+#define LLC_PREFETCHER_CHECKPOINT(name) CALL_MODULE(LLC_PREFETCHER_##name, llc_prefetcher_checkpoint_##name, checkpoint)
+#define LLC_REPLACEMENT_CHECKPOINT(name) CALL_MODULE(LLC_REPLACEMENT_##name, llc_replacement_checkpoint_##name, checkpoint)
+
+void O3_CPU::checkpoint_branch_predictor(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_BRANCH_PREDICTOR]) {
+        BRANCH_PREDICTORS(CHECKPOINT_BRANCH_PREDICTOR)
+    }
+}
+
+void O3_CPU::l1i_prefetcher_checkpoint(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_L1I_PREFETCHER]) {
+        L1I_PREFETCHERS(L1I_PREFETCHER_CHECKPOINT)
+    }
+}
+
+void CACHE::l1d_prefetcher_checkpoint(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_L1D_PREFETCHER]) {
+        L1D_PREFETCHERS(L1D_PREFETCHER_CHECKPOINT)
+    }
+}
+
+void CACHE::l2c_prefetcher_checkpoint(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_L2C_PREFETCHER]) {
+        L2C_PREFETCHERS(L2C_PREFETCHER_CHECKPOINT)
+    }
+}
+
+void CACHE::llc_prefetcher_checkpoint(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_LLC_PREFETCHER]) {
+        LLC_PREFETCHERS(LLC_PREFETCHER_CHECKPOINT)
+    }
+}
+
+void CACHE::llc_replacement_checkpoint(CHECKPOINT &checkpoint)
+{
+    switch (selected_module[MODULE_LLC_REPLACEMENT]) {
+        LLC_REPLACEMENTS(LLC_REPLACEMENT_CHECKPOINT)
+    }
+}
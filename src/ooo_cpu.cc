@@ -1,8 +1,10 @@
 #include "ooo_cpu.h"
 #include "set.h"
+#include "checkpoint.h"
+#include <algorithm>
 
 // out-of-order core
-O3_CPU ooo_cpu[NUM_CPUS]; 
+O3_CPU *ooo_cpu; 
 uint64_t current_core_cycle[NUM_CPUS], stall_cycle[NUM_CPUS];
 uint32_t SCHEDULING_LATENCY = 0, EXEC_LATENCY = 0, DECODE_LATENCY = 0;
 
@@ -16,383 +18,194 @@ void O3_CPU::read_from_trace()
     // actual processors do not work like this but for easier implementation,
     // we read instruction traces and virtually add them in the ROB
     // note that these traces are not yet translated and fetched 
+    // decompression and conversion into ooo_model_instr happen on the trace decoder thread
 
     uint8_t continue_reading = 1;
     uint32_t num_reads = 0;
     instrs_to_read_this_cycle = FETCH_WIDTH;
 
-    // first, read PIN trace
     while (continue_reading) {
 
-        size_t instr_size = knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
+        uint8_t rewound = 0;
+        ooo_model_instr *arch_instr = trace_decoder->next_instr(&rewound);
 
-        if (knob_cloudsuite) {
-            if (!fread(&current_cloudsuite_instr, instr_size, 1, trace_file)) {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-                    cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
-                }
-            } else { // successfully read the trace
+        if (rewound) {
+            // reached end of file for this trace, the decoder already went back to the beginning
+            cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
+            trace_rewinds.push_back(instr_unique_id);
+        }
 
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
+        arch_instr->instr_id = instr_unique_id;
+        if (knob_cloudsuite == 0) {
+            arch_instr->asid[0] = cpu;
+            arch_instr->asid[1] = cpu;
+        }
 
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_cloudsuite_instr.ip;
-                arch_instr.is_branch = current_cloudsuite_instr.is_branch;
-                arch_instr.branch_taken = current_cloudsuite_instr.branch_taken;
+        for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+            if (arch_instr->destination_memory[i]) {
+                // update STA, this structure is required to execute store instructions properly without deadlock
+#ifdef SANITY_CHECK
+                if (STA[STA_tail] < UINT64_MAX) {
+                    if (STA_head != STA_tail)
+                        assert(0);
+                }
+#endif
+                STA[STA_tail] = instr_unique_id;
+                STA_tail++;
 
-                arch_instr.asid[0] = current_cloudsuite_instr.asid[0];
-                arch_instr.asid[1] = current_cloudsuite_instr.asid[1];
+                if (STA_tail == STA_SIZE)
+                    STA_tail = 0;
+            }
+        }
 
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_cloudsuite_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_cloudsuite_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_cloudsuite_instr.destination_memory[i];
+        if (knob_cloudsuite == 0)
+            total_branch_types[arch_instr->branch_type]++;
 
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
+        // add this instruction to the IFETCH_BUFFER
+        if (IFETCH_BUFFER.occupancy < IFETCH_BUFFER.SIZE) {
+            uint32_t ifetch_buffer_index = add_to_ifetch_buffer(arch_instr);
+            num_reads++;
 
-                        // update STA, this structure is required to execute store instructions properly without deadlock
-                        if (num_mem_ops > 0) {
-#ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
-#endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
+            // handle branch prediction
+            if (IFETCH_BUFFER.entry[ifetch_buffer_index].is_branch) {
 
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
-                    }
-                }
+                DP( if (warmup_complete[cpu]) {
+                cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr->ip << dec << " taken: " << +arch_instr->branch_taken << endl; });
 
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_cloudsuite_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_cloudsuite_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_cloudsuite_instr.source_memory[i];
+                num_branch++;
 
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
-                }
+                // handle branch prediction & branch predictor update
+                uint8_t branch_prediction = predict_branch(IFETCH_BUFFER.entry[ifetch_buffer_index].ip);
 
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
-
-                // add this instruction to the IFETCH_BUFFER
-                if (IFETCH_BUFFER.occupancy < IFETCH_BUFFER.SIZE) {
-		  uint32_t ifetch_buffer_index = add_to_ifetch_buffer(&arch_instr);
-		  num_reads++;
-
-		  // handle branch prediction
-		  if (IFETCH_BUFFER.entry[ifetch_buffer_index].is_branch) {
-		    DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
-		    
-		    num_branch++;
-		    
-		    // handle branch prediction & branch predictor update
-		    uint8_t branch_prediction = predict_branch(IFETCH_BUFFER.entry[ifetch_buffer_index].ip);
-		    
-		    if(IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken != branch_prediction)
-		      {
-			branch_mispredictions++;
-			total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
-			if(warmup_complete[cpu])
-			  {
-			    fetch_stall = 1;
-			    instrs_to_read_this_cycle = 0;
-			    IFETCH_BUFFER.entry[ifetch_buffer_index].branch_mispredicted = 1;
-			  }
-		      }
-		    else
-		      {
-			// correct prediction
-			if(branch_prediction == 1)
-			  {
-			    // if correctly predicted taken, then we can't fetch anymore instructions this cycle
-			    instrs_to_read_this_cycle = 0;
-			  }
-		      }
-		    
-		    last_branch_result(IFETCH_BUFFER.entry[ifetch_buffer_index].ip, IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken);
-		  }
-		  
-		  if ((num_reads >= instrs_to_read_this_cycle) || (IFETCH_BUFFER.occupancy == IFETCH_BUFFER.SIZE))
-		    continue_reading = 0;
-                }
-                instr_unique_id++;
-            }
-        }
-	else
-	  {
-	    input_instr trace_read_instr;
-            if (!fread(&trace_read_instr, instr_size, 1, trace_file))
-	      {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-		
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-		  cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
+                if (knob_cloudsuite == 0) {
+                    uint64_t predicted_branch_target = IFETCH_BUFFER.entry[ifetch_buffer_index].branch_target;
+                    if(branch_prediction == 0)
+                      {
+                        predicted_branch_target = 0;
+                      }
+                    // call code prefetcher every time the branch predictor is used
+                    l1i_prefetcher_branch_operate(IFETCH_BUFFER.entry[ifetch_buffer_index].ip,
+                                                  IFETCH_BUFFER.entry[ifetch_buffer_index].branch_type,
+                                                  predicted_branch_target);
                 }
-            }
-	    else
-	      { // successfully read the trace
 
-		if(instr_unique_id == 0)
-		  {
-		    current_instr = next_instr = trace_read_instr;
-		  }
-		else
-		  {
-		    current_instr = next_instr;
-		    next_instr = trace_read_instr;
-		  }
-
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
+                if(IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken != branch_prediction)
+                  {
+                    branch_mispredictions++;
+                    total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
+                    if(warmup_complete[cpu])
+                      {
+                        fetch_stall = 1;
+                        instrs_to_read_this_cycle = 0;
+                        IFETCH_BUFFER.entry[ifetch_buffer_index].branch_mispredicted = 1;
+                      }
+                  }
+                else
+                  {
+                    // correct prediction
+                    if(branch_prediction == 1)
+                      {
+                        // if correctly predicted taken, then we can't fetch anymore instructions this cycle
+                        instrs_to_read_this_cycle = 0;
+                      }
+                  }
 
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_instr.ip;
-                arch_instr.is_branch = current_instr.is_branch;
-                arch_instr.branch_taken = current_instr.branch_taken;
+                last_branch_result(IFETCH_BUFFER.entry[ifetch_buffer_index].ip, IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken);
+            }
 
-                arch_instr.asid[0] = cpu;
-                arch_instr.asid[1] = cpu;
+            if ((num_reads >= instrs_to_read_this_cycle) || (IFETCH_BUFFER.occupancy == IFETCH_BUFFER.SIZE))
+                continue_reading = 0;
+        }
+        instr_unique_id++;
+    }
 
-		bool reads_sp = false;
-		bool writes_sp = false;
-		bool reads_flags = false;
-		bool reads_ip = false;
-		bool writes_ip = false;
-		bool reads_other = false;
+    //instrs_to_fetch_this_cycle = num_reads;
+}
 
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_instr.destination_memory[i];
-
-		    switch(arch_instr.destination_registers[i])
-		      {
-		      case 0:
-			break;
-		      case REG_STACK_POINTER:
-			writes_sp = true;
-			break;
-		      case REG_INSTRUCTION_POINTER:
-			writes_ip = true;
-			break;
-		      default:
-			break;
-		      }
-
-		    /*
-		    if((arch_instr.is_branch) && (arch_instr.destination_registers[i] > 24) && (arch_instr.destination_registers[i] < 28))
-		      {
-			arch_instr.destination_registers[i] = 0;
-		      }
-		    */
-		    
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
-
-                        // update STA, this structure is required to execute store instructions properly without deadlock
-                        if (num_mem_ops > 0) {			  
-#ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
-#endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
+void O3_CPU::functional_instruction()
+{
+    uint8_t rewound = 0;
+    ooo_model_instr *arch_instr = trace_decoder->next_instr(&rewound);
 
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
-                    }
-                }
+    if (rewound) {
+        cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
+        trace_rewinds.push_back(instr_unique_id);
+    }
 
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_instr.source_memory[i];
+    arch_instr->instr_id = instr_unique_id;
+    if (knob_cloudsuite == 0) {
+        arch_instr->asid[0] = cpu;
+        arch_instr->asid[1] = cpu;
+    }
 
-		    switch(arch_instr.source_registers[i])
-                      {
-                      case 0:
-                        break;
-                      case REG_STACK_POINTER:
-                        reads_sp = true;
-                        break;
-                      case REG_FLAGS:
-                        reads_flags = true;
-                        break;
-                      case REG_INSTRUCTION_POINTER:
-                        reads_ip = true;
-                        break;
-                      default:
-                        reads_other = true;
-                        break;
-                      }
-		    
-		    /*
-		    if((!arch_instr.is_branch) && (arch_instr.source_registers[i] > 25) && (arch_instr.source_registers[i] < 28))
-		      {
-			arch_instr.source_registers[i] = 0;
-		      }
-		    */
-		    
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
-                }
+    // branch predictor and code prefetcher train as in read_from_trace
+    if (arch_instr->is_branch) {
+        uint8_t branch_prediction = predict_branch(arch_instr->ip);
 
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
+        if (knob_cloudsuite == 0)
+            l1i_prefetcher_branch_operate(arch_instr->ip, arch_instr->branch_type, branch_prediction ? arch_instr->branch_target : 0);
 
-		// determine what kind of branch this is, if any
-		if(!reads_sp && !reads_flags && writes_ip && !reads_other)
-		  {
-		    // direct jump
-		    arch_instr.is_branch = 1;
-                    arch_instr.branch_taken = 1;
-                    arch_instr.branch_type = BRANCH_DIRECT_JUMP;
-		  }
-		else if(!reads_sp && !reads_flags && writes_ip && reads_other)
-		  {
-		    // indirect branch
-		    arch_instr.is_branch = 1;
-                    arch_instr.branch_taken = 1;
-                    arch_instr.branch_type = BRANCH_INDIRECT;
-		  }
-		else if(!reads_sp && reads_ip && !writes_sp && writes_ip && reads_flags && !reads_other)
-		  {
-		    // conditional branch
-		    arch_instr.is_branch = 1;
-		    arch_instr.branch_taken = arch_instr.branch_taken; // don't change this
-		    arch_instr.branch_type = BRANCH_CONDITIONAL;
-		  }
-		else if(reads_sp && reads_ip && writes_sp && writes_ip && !reads_flags && !reads_other)
-		  {
-		    // direct call
-		    arch_instr.is_branch = 1;
-		    arch_instr.branch_taken = 1;
-		    arch_instr.branch_type = BRANCH_DIRECT_CALL;
-		  }
-		else if(reads_sp && reads_ip && writes_sp && writes_ip && !reads_flags && reads_other)
-		  {
-		    // indirect call
-		    arch_instr.is_branch = 1;
-		    arch_instr.branch_taken = 1;
-		    arch_instr.branch_type = BRANCH_INDIRECT_CALL;
-		  }
-		else if(reads_sp && !reads_ip && writes_sp && writes_ip)
-		  {
-		    // return
-		    arch_instr.is_branch = 1;
-		    arch_instr.branch_taken = 1;
-		    arch_instr.branch_type = BRANCH_RETURN;
-		  }
-		else if(writes_ip)
-		  {
-		    // some other branch type that doesn't fit the above categories
-		    arch_instr.is_branch = 1;
-                    arch_instr.branch_taken = arch_instr.branch_taken; // don't change this
-                    arch_instr.branch_type = BRANCH_OTHER;
-		  }
+        last_branch_result(arch_instr->ip, arch_instr->branch_taken);
+    }
+    l1i_prefetcher_cycle_operate();
 
-		total_branch_types[arch_instr.branch_type]++;
-		
-		if((arch_instr.is_branch == 1) && (arch_instr.branch_taken == 1))
-		  {
-		    arch_instr.branch_target = next_instr.ip;
-		  }
+    // the fetch unit translates and sends a block to the L1I once for a run of instructions in it
+    if ((arch_instr->ip >> LOG2_BLOCK_SIZE) != functional_fetch_block) {
+        uint64_t instr_pa = va_to_pa(cpu, instr_unique_id, arch_instr->ip, (arch_instr->ip)>>LOG2_PAGE_SIZE, 1);
+        instr_pa = ((instr_pa >> LOG2_PAGE_SIZE) << LOG2_PAGE_SIZE) | (arch_instr->ip & ((1 << LOG2_PAGE_SIZE) - 1));
+
+        PACKET fetch_packet;
+        fetch_packet.instruction = 1;
+        fetch_packet.is_data = 0;
+        fetch_packet.fill_level = FILL_L1;
+        fetch_packet.fill_l1i = 1;
+        fetch_packet.cpu = cpu;
+        fetch_packet.address = instr_pa >> LOG2_BLOCK_SIZE;
+        fetch_packet.instruction_pa = instr_pa;
+        fetch_packet.full_addr = instr_pa;
+        fetch_packet.instr_id = instr_unique_id;
+        fetch_packet.ip = arch_instr->ip;
+        fetch_packet.type = LOAD;
+
+        L1I.functional_access(&fetch_packet);
+        functional_fetch_block = arch_instr->ip >> LOG2_BLOCK_SIZE;
+    }
 
-                // add this instruction to the IFETCH_BUFFER
-                if (IFETCH_BUFFER.occupancy < IFETCH_BUFFER.SIZE) {
-		  uint32_t ifetch_buffer_index = add_to_ifetch_buffer(&arch_instr);
-		  num_reads++;
-
-                    // handle branch prediction
-                    if (IFETCH_BUFFER.entry[ifetch_buffer_index].is_branch) {
-
-                        DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
-
-                        num_branch++;
-
-			// handle branch prediction & branch predictor update
-			uint8_t branch_prediction = predict_branch(IFETCH_BUFFER.entry[ifetch_buffer_index].ip);
-			uint64_t predicted_branch_target = IFETCH_BUFFER.entry[ifetch_buffer_index].branch_target;
-			if(branch_prediction == 0)
-			  {
-			    predicted_branch_target = 0;
-			  }
-			// call code prefetcher every time the branch predictor is used
-			l1i_prefetcher_branch_operate(IFETCH_BUFFER.entry[ifetch_buffer_index].ip,
-						      IFETCH_BUFFER.entry[ifetch_buffer_index].branch_type,
-						      predicted_branch_target);
-			
-			if(IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken != branch_prediction)
-			  {
-			    branch_mispredictions++;
-			    total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
-			    if(warmup_complete[cpu])
-			      {
-				fetch_stall = 1;
-				instrs_to_read_this_cycle = 0;
-				IFETCH_BUFFER.entry[ifetch_buffer_index].branch_mispredicted = 1;
-			      }
-			  }
-			else
-			  {
-			    // correct prediction
-			    if(branch_prediction == 1)
-			      {
-				// if correctly predicted taken, then we can't fetch anymore instructions this cycle
-				instrs_to_read_this_cycle = 0;
-			      }
-			  }
-			
-			last_branch_result(IFETCH_BUFFER.entry[ifetch_buffer_index].ip, IFETCH_BUFFER.entry[ifetch_buffer_index].branch_taken);
-                    }
+    // loads, then stores, each translated by the DTLB before it goes to the L1D
+    uint32_t num_memory = NUM_INSTR_SOURCES + MAX_INSTR_DESTINATIONS;
+    for (uint32_t i=0; i<num_memory; i++) {
+        uint64_t virtual_address = (i < NUM_INSTR_SOURCES) ? arch_instr->source_memory[i] : arch_instr->destination_memory[i-NUM_INSTR_SOURCES];
+        if (virtual_address == 0)
+            continue;
 
-                    if ((num_reads >= instrs_to_read_this_cycle) || (IFETCH_BUFFER.occupancy == IFETCH_BUFFER.SIZE))
-                        continue_reading = 0;
-                }
-                instr_unique_id++;
-            }
-        }
+        PACKET data_packet;
+        data_packet.tlb_access = 1;
+        data_packet.fill_level = FILL_L1;
+        data_packet.fill_l1d = 1;
+        data_packet.cpu = cpu;
+        if (knob_cloudsuite)
+            data_packet.address = ((virtual_address >> LOG2_PAGE_SIZE) << 9) | arch_instr->asid[1];
+        else
+            data_packet.address = virtual_address >> LOG2_PAGE_SIZE;
+        data_packet.full_addr = virtual_address;
+        data_packet.instr_id = instr_unique_id;
+        data_packet.ip = arch_instr->ip;
+        data_packet.type = (i < NUM_INSTR_SOURCES) ? LOAD : RFO;
+        data_packet.asid[0] = arch_instr->asid[0];
+        data_packet.asid[1] = arch_instr->asid[1];
+
+        DTLB.functional_access(&data_packet);
+
+        uint64_t physical_address = (data_packet.data << LOG2_PAGE_SIZE) | (virtual_address & ((1 << LOG2_PAGE_SIZE) - 1));
+        data_packet.tlb_access = 0;
+        data_packet.address = physical_address >> LOG2_BLOCK_SIZE;
+        data_packet.full_addr = physical_address;
+
+        L1D.functional_access(&data_packet);
     }
 
-    //instrs_to_fetch_this_cycle = num_reads;
+    instr_unique_id++;
+    num_retired++;
 }
 
 uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
@@ -409,6 +222,25 @@ uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
     ROB.entry[index] = *arch_instr;
     ROB.entry[index].event_cycle = current_core_cycle[cpu];
 
+    // rename, sources first since an instruction may read and write the same register
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        uint8_t reg = ROB.entry[index].source_registers[i];
+        if (reg) {
+            ROB.entry[index].source_writer[i] = register_writer[reg];
+            ROB.entry[index].source_writer_id[i] = register_writer_id[reg];
+        }
+    }
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        uint8_t reg = ROB.entry[index].destination_registers[i];
+        if ((reg == 0) || ((register_writer[reg] == index) && (register_writer_id[reg] == ROB.entry[index].instr_id)))
+            continue; // the register is also named by an earlier destination
+        ROB.entry[index].previous_writer[i] = register_writer[reg];
+        ROB.entry[index].previous_writer_id[i] = register_writer_id[reg];
+        register_writer[reg] = index;
+        register_writer_id[reg] = ROB.entry[index].instr_id;
+    }
+    add_store_addresses(index);
+
     ROB.occupancy++;
     ROB.tail++;
     if (ROB.tail >= ROB.SIZE)
@@ -513,32 +345,15 @@ uint32_t O3_CPU::check_rob(uint64_t instr_id)
     if ((ROB.head == ROB.tail) && ROB.occupancy == 0)
         return ROB.SIZE;
 
-    if (ROB.head < ROB.tail) {
-        for (uint32_t i=ROB.head; i<ROB.tail; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
-                DP ( if (warmup_complete[ROB.cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
-            }
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
-                DP ( if (warmup_complete[cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
-            }
-        }
-        for (uint32_t i=0; i<ROB.tail; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
-                DP ( if (warmup_complete[cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
-            }
+    // instructions enter the ROB in instr_id order with no gaps, so the index follows from the head
+    uint64_t offset = instr_id - ROB.entry[ROB.head].instr_id;
+    if ((instr_id >= ROB.entry[ROB.head].instr_id) && (offset < ROB.occupancy)) {
+        uint32_t index = (ROB.head + offset) % ROB.SIZE;
+        if (ROB.entry[index].instr_id == instr_id) {
+            DP ( if (warmup_complete[cpu]) {
+            cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[index].instr_id;
+            cout << " rob_index: " << index << endl; });
+            return index;
         }
     }
 
@@ -936,32 +751,47 @@ void O3_CPU::reg_dependency(uint32_t rob_index)
         }
     } }); 
 
-    // check RAW dependency
-    int prior = rob_index - 1;
-    if (prior < 0)
-        prior = ROB.SIZE - 1;
-
-    if (rob_index != ROB.head) {
-        if ((int)ROB.head <= prior) {
-            for (int i=prior; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-        } else {
-            for (int i=prior; i>=0; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-            for (int i=ROB.SIZE-1; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
+    // check RAW dependency, the producer of a source is the youngest older instruction writing its register that has not completed,
+    // found by following the rename links from writer to previous writer until an instruction that already retired
+    uint32_t producer[NUM_INSTR_SOURCES];
+    for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+        producer[j] = UINT32_MAX;
+        uint8_t reg = ROB.entry[rob_index].source_registers[j];
+        if ((reg == 0) || ROB.entry[rob_index].reg_RAW_checked[j])
+            continue;
+
+        uint32_t writer = ROB.entry[rob_index].source_writer[j];
+        uint64_t writer_id = ROB.entry[rob_index].source_writer_id[j];
+        while ((writer != UINT32_MAX) && ROB.entry[writer].ip && (ROB.entry[writer].instr_id == writer_id)) {
+            if (ROB.entry[writer].executed != COMPLETED) {
+                producer[j] = writer;
+                break;
+            }
+
+            uint32_t k = 0;
+            while (ROB.entry[writer].destination_registers[k] != reg)
+                k++;
+            writer_id = ROB.entry[writer].previous_writer_id[k];
+            writer = ROB.entry[writer].previous_writer[k];
+        }
+    }
+
+    // youngest producer first, as the walk from this entry back to the ROB head used to find them
+    while (1) {
+        uint32_t youngest = NUM_INSTR_SOURCES;
+        for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+            if ((producer[j] != UINT32_MAX) && ((youngest == NUM_INSTR_SOURCES) || (ROB.entry[producer[j]].instr_id > ROB.entry[producer[youngest]].instr_id)))
+                youngest = j;
+        }
+        if (youngest == NUM_INSTR_SOURCES)
+            break;
+
+        uint32_t prior = producer[youngest];
+        for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+            if (producer[j] == prior) {
+                reg_RAW_dependency(prior, rob_index, j);
+                producer[j] = UINT32_MAX;
+            }
         }
     }
 }
@@ -1068,6 +898,7 @@ void O3_CPU::do_execution(uint32_t rob_index)
             ROB.entry[rob_index].event_cycle += EXEC_LATENCY;
 
         inflight_reg_executions++;
+        add_completion_event(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " non-memory instr_id: " << ROB.entry[rob_index].instr_id; 
@@ -1135,6 +966,7 @@ void O3_CPU::do_memory_scheduling(uint32_t rob_index)
         ROB.entry[rob_index].scheduled = COMPLETED;
         if (ROB.entry[rob_index].executed == 0) // it could be already set to COMPLETED due to store-to-load forwarding
             ROB.entry[rob_index].executed  = INFLIGHT;
+        add_completion_event(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[rob_index].instr_id << " rob_index: " << rob_index;
@@ -1202,14 +1034,8 @@ uint32_t O3_CPU::check_and_add_lsq(uint32_t rob_index)
 
 void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
 {
-    // search for an empty slot 
-    uint32_t lq_index = LQ.SIZE;
-    for (uint32_t i=0; i<LQ.SIZE; i++) {
-        if (LQ.entry[i].virtual_address == 0) {
-            lq_index = i;
-            break;
-        }
-    }
+    // lowest empty slot
+    uint32_t lq_index = LQ.slots->allocate(ROB.entry[rob_index].source_memory[data_index]);
 
     // sanity check
     if (lq_index == LQ.SIZE) {
@@ -1229,53 +1055,37 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
     LQ.entry[lq_index].event_cycle = current_core_cycle[cpu] + SCHEDULING_LATENCY;
     LQ.occupancy++;
 
-    // check RAW dependency
-    int prior = rob_index - 1;
-    if (prior < 0)
-        prior = ROB.SIZE - 1;
-
-    if (rob_index != ROB.head) {
-        if ((int)ROB.head <= prior) {
-            for (int i=prior; i>=(int)ROB.head; i--) {
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                    break;
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
-        }
-        else {
-            for (int i=prior; i>=0; i--) {
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                    break;
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
-            for (int i=ROB.SIZE-1; i>=(int)ROB.head; i--) { 
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                    break;
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
+    // check RAW dependency, the youngest older store to the same address in the ROB is the producer
+    uint64_t address = LQ.entry[lq_index].virtual_address;
+    for (uint32_t slot = store_bucket[store_hash(address)]; slot != UINT32_MAX; slot = store_next[slot]) {
+        uint32_t prior = slot / NUM_INSTR_DESTINATIONS_SPARC;
+        if ((ROB.entry[prior].destination_memory[slot % NUM_INSTR_DESTINATIONS_SPARC] == address) && (ROB.entry[prior].instr_id < ROB.entry[rob_index].instr_id)) {
+            mem_RAW_dependency(prior, rob_index, data_index, lq_index);
+            break;
         }
     }
 
     // check
     // 1) if store-to-load forwarding is possible
     // 2) if there is WAR that are not correctly executed
+    // only the SQ entries of the stores to the same address can match
     uint32_t forwarding_index = SQ.SIZE;
-    for (uint32_t i=0; i<SQ.SIZE; i++) {
+    for (uint32_t slot = store_bucket[store_hash(address)]; slot != UINT32_MAX; slot = store_next[slot]) {
+        uint32_t store_rob_index = slot / NUM_INSTR_DESTINATIONS_SPARC,
+                 i = ROB.entry[store_rob_index].sq_index[slot % NUM_INSTR_DESTINATIONS_SPARC];
 
-        // skip empty slot
-        if (SQ.entry[i].virtual_address == 0)
+        // skip stores not in the SQ yet
+        if (i == UINT32_MAX)
             continue;
 
         // forwarding should be done by the SQ entry that holds the same producer_id from RAW dependency check
         if (SQ.entry[i].virtual_address == LQ.entry[lq_index].virtual_address) { // store-to-load forwarding check
 
-            // forwarding store is in the SQ
+            // forwarding store is in the SQ, the first one in SQ order when an instruction stores twice to the address
             if ((rob_index != ROB.head) && (LQ.entry[lq_index].producer_id == SQ.entry[i].instr_id)) { // RAW
-                forwarding_index = i;
-                break; // should be break
+                if (i < forwarding_index)
+                    forwarding_index = i;
+                continue;
             }
 
             if ((LQ.entry[lq_index].producer_id == UINT64_MAX) && (LQ.entry[lq_index].instr_id <= SQ.entry[i].instr_id)) { // WAR 
@@ -1321,6 +1131,7 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
             }
             if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
                 inflight_mem_executions++;
+            add_completion_event(fwr_rob_index);
 
             DP(if(warmup_complete[cpu]) {
             cout << "[LQ] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1376,6 +1187,42 @@ void O3_CPU::mem_RAW_dependency(uint32_t prior, uint32_t current, uint32_t data_
     }
 }
 
+// stores enter the address hash at dispatch and leave it at retirement
+void O3_CPU::add_store_addresses(uint32_t rob_index)
+{
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        if (ROB.entry[rob_index].destination_memory[i] == 0)
+            continue;
+
+        uint32_t slot = rob_index*NUM_INSTR_DESTINATIONS_SPARC + i,
+                 bucket = store_hash(ROB.entry[rob_index].destination_memory[i]);
+        store_next[slot] = store_bucket[bucket];
+        store_bucket[bucket] = slot;
+    }
+}
+
+void O3_CPU::remove_store_addresses(uint32_t rob_index)
+{
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        if (ROB.entry[rob_index].destination_memory[i] == 0)
+            continue;
+
+        uint32_t slot = rob_index*NUM_INSTR_DESTINATIONS_SPARC + i,
+                 *link = &store_bucket[store_hash(ROB.entry[rob_index].destination_memory[i])];
+        while (*link != slot) {
+#ifdef SANITY_CHECK
+            if (*link == UINT32_MAX) {
+                cerr << "[ROB] " << __func__ << " instr_id: " << ROB.entry[rob_index].instr_id << " store slot: " << slot << " is not in the address hash" << endl;
+                assert(0);
+            }
+#endif
+            link = &store_next[*link];
+        }
+        *link = store_next[slot];
+        store_next[slot] = UINT32_MAX;
+    }
+}
+
 void O3_CPU::add_store_queue(uint32_t rob_index, uint32_t data_index)
 {
     uint32_t sq_index = SQ.tail;
@@ -1623,6 +1470,7 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
     }
     if (ROB.entry[rob_index].num_mem_ops == 0)
         inflight_mem_executions++;
+    add_completion_event(rob_index);
 
     DP (if (warmup_complete[cpu]) {
     cout << "[SQ1] " << __func__ << " instr_id: " << SQ.entry[sq_index].instr_id << hex;
@@ -1666,6 +1514,7 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
 #endif
                         if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
                             inflight_mem_executions++;
+                        add_completion_event(fwr_rob_index);
 
                         DP(if(warmup_complete[cpu]) {
                         cout << "[LQ3] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1816,6 +1665,134 @@ void O3_CPU::operate_cache()
     l1i_prefetcher_cycle_operate();
 }
 
+// earliest cycle at which operate_cpu() may change anything in the core or its private caches, nothing changes before it.
+// every stage is gated on the same conditions as in operate_cpu(), the next cycle is returned whenever one of them would run
+uint64_t O3_CPU::next_operate_cycle()
+{
+    uint64_t cycle = current_core_cycle[cpu] + 1, // the next cycle to simulate
+             next_cycle = UINT64_MAX;
+    auto wait_for = [&next_cycle](uint64_t event_cycle) { if (event_cycle < next_cycle) next_cycle = event_cycle; };
+
+    // a page fault stops the core and its caches
+    if (stall_cycle[cpu] > cycle)
+        return stall_cycle[cpu];
+
+    if (l1i_prefetcher_cycle_idle() == 0)
+        return cycle;
+
+    // read from trace and fetch
+    if ((IFETCH_BUFFER.occupancy < IFETCH_BUFFER.SIZE) && (fetch_stall == 0))
+        return cycle;
+    if ((fetch_stall == 1) && (fetch_resume_cycle != 0))
+        wait_for(fetch_resume_cycle);
+
+    uint32_t index = IFETCH_BUFFER.head;
+    for (uint32_t i=0; (i<IFETCH_BUFFER.SIZE) && IFETCH_BUFFER.entry[index].ip; i++) {
+        if ((IFETCH_BUFFER.entry[index].translated == 0) || ((IFETCH_BUFFER.entry[index].translated == COMPLETED) && (IFETCH_BUFFER.entry[index].fetched == 0)))
+            return cycle;
+        index = (index + 1) % IFETCH_BUFFER.SIZE;
+    }
+
+    ooo_model_instr &fetch_head = IFETCH_BUFFER.entry[IFETCH_BUFFER.head];
+    if (fetch_head.ip && (fetch_head.translated == COMPLETED) && (fetch_head.fetched == COMPLETED) && (DECODE_BUFFER.occupancy < DECODE_BUFFER.SIZE))
+        return cycle;
+
+    // decode and dispatch
+    ooo_model_instr &decode_head = DECODE_BUFFER.entry[DECODE_BUFFER.head];
+    if (DECODE_BUFFER.occupancy && decode_head.ip) {
+        if (ROB.occupancy < ROB.SIZE) {
+            if ((warmup_complete[cpu] == 0) || (decode_head.event_cycle == 0))
+                return cycle;
+            wait_for(decode_head.event_cycle + 1);
+        }
+
+        index = DECODE_BUFFER.head;
+        for (uint32_t i=0; i<DECODE_BUFFER.SIZE; i++) {
+            if (DECODE_BUFFER.entry[index].event_cycle == 0)
+                return cycle;
+            if (index == DECODE_BUFFER.tail)
+                break;
+            index = (index + 1) % DECODE_BUFFER.SIZE;
+        }
+    }
+
+    // retire
+    if (ROB.entry[ROB.head].executed == COMPLETED)
+        wait_for(ROB.entry[ROB.head].event_cycle);
+
+    // complete
+    PACKET_QUEUE *processed[4] = { &ITLB.PROCESSED, &L1I.PROCESSED, &DTLB.PROCESSED, &L1D.PROCESSED };
+    for (uint32_t i=0; i<4; i++)
+        if (processed[i]->occupancy)
+            wait_for(processed[i]->entry[processed[i]->head].event_cycle);
+    if (completion_events.size())
+        wait_for(completion_events.top().event_cycle);
+
+    if (ROB.occupancy) {
+        // schedule, the scan of schedule_instruction() stops at the first instruction that is not ready
+        ooo_model_instr &next_schedule = ROB.entry[ROB.next_schedule];
+        if ((next_schedule.scheduled == 0) && (next_schedule.event_cycle > cycle))
+            wait_for(next_schedule.event_cycle);
+        else if (next_schedule.scheduled == 0) {
+            uint32_t limit = ROB.next_fetch[1],
+                     count = (ROB.head < limit) ? (limit - ROB.head) : (ROB.SIZE - ROB.head + limit);
+            for (uint32_t i=0; (i<count) && (i<SCHEDULER_SIZE); i++) {
+                ooo_model_instr &entry = ROB.entry[(ROB.head + i) % ROB.SIZE];
+                if (entry.fetched != COMPLETED)
+                    break;
+                if (entry.event_cycle > cycle) {
+                    wait_for(entry.event_cycle);
+                    break;
+                }
+                if (entry.scheduled == 0)
+                    return cycle;
+            }
+        }
+
+        // execute
+        if (RTE0[RTE0_head] < ROB_SIZE)
+            wait_for(ROB.entry[RTE0[RTE0_head]].event_cycle);
+        if (RTE1[RTE1_head] < ROB_SIZE)
+            wait_for(ROB.entry[RTE1[RTE1_head]].event_cycle);
+
+        // memory scheduling, walks [head, next_schedule) and, when it wraps, [0, next_schedule) on its own
+        uint32_t limit = ROB.next_schedule,
+                 begin[2] = { ROB.head, 0 },
+                 end[2] = { (ROB.head < limit) ? limit : ROB.SIZE, (ROB.head < limit) ? 0 : limit };
+        for (uint32_t j=0; j<2; j++) {
+            for (uint32_t i=begin[j]; i<end[j]; i++) {
+                if (ROB.entry[i].is_memory == 0)
+                    continue;
+                if (ROB.entry[i].fetched != COMPLETED)
+                    break;
+                if (ROB.entry[i].event_cycle > cycle) {
+                    wait_for(ROB.entry[i].event_cycle);
+                    break;
+                }
+                if (ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
+                    return cycle;
+            }
+        }
+    }
+
+    // load/store queues
+    if (RTS0[RTS0_head] < SQ_SIZE)
+        wait_for(SQ.entry[RTS0[RTS0_head]].event_cycle);
+    if (RTS1[RTS1_head] < SQ_SIZE)
+        wait_for(SQ.entry[RTS1[RTS1_head]].event_cycle);
+    if (RTL0[RTL0_head] < LQ_SIZE)
+        wait_for(LQ.entry[RTL0[RTL0_head]].event_cycle);
+    if (RTL1[RTL1_head] < LQ_SIZE)
+        wait_for(LQ.entry[RTL1[RTL1_head]].event_cycle);
+
+    // private caches
+    CACHE *cache[6] = { &ITLB, &DTLB, &STLB, &L1I, &L1D, &L2C };
+    for (uint32_t i=0; i<6; i++)
+        wait_for(cache[i]->next_operate_cycle());
+
+    return (next_cycle > cycle) ? next_cycle : cycle;
+}
+
 void O3_CPU::update_rob()
 {
     if (ITLB.PROCESSED.occupancy && (ITLB.PROCESSED.entry[ITLB.PROCESSED.head].event_cycle <= current_core_cycle[cpu]))
@@ -1831,20 +1808,42 @@ void O3_CPU::update_rob()
         complete_data_fetch(&L1D.PROCESSED, 0);
 
     // update ROB entries with completed executions
-    if ((inflight_reg_executions > 0) || (inflight_mem_executions > 0)) {
-        if (ROB.head < ROB.tail) {
-            for (uint32_t i=ROB.head; i<ROB.tail; i++) 
-                complete_execution(i);
-        }
-        else {
-            for (uint32_t i=ROB.head; i<ROB.SIZE; i++)
-                complete_execution(i);
-            for (uint32_t i=0; i<ROB.tail; i++)
-                complete_execution(i);
+    while (completion_events.size() && (completion_events.top().event_cycle <= current_core_cycle[cpu])) {
+        completion_event event = completion_events.top();
+        completion_events.pop();
+
+        uint32_t rob_index = event.rob_index;
+        if ((ROB.entry[rob_index].instr_id != event.instr_id) || (ROB.entry[rob_index].executed != INFLIGHT))
+            continue; // already completed, or retired and the entry reused
+        if (ROB.entry[rob_index].event_cycle > current_core_cycle[cpu]) {
+            completion_events.push(completion_event(ROB.entry[rob_index].event_cycle, event.instr_id, rob_index));
+            continue;
         }
+        completing.push_back(rob_index);
+    }
+
+    if (completing.size()) {
+        // in program order, as a walk from the ROB head would find them
+        uint32_t head = ROB.head, size = ROB.SIZE;
+        sort(completing.begin(), completing.end(), [head, size](uint32_t a, uint32_t b) { return ((a + size - head) % size) < ((b + size - head) % size); });
+        for (uint32_t i=0; i<completing.size(); i++)
+            complete_execution(completing[i]);
+        completing.clear();
     }
 }
 
+// queues an instruction that can complete once it reaches its event_cycle,
+// called whenever it becomes ready to complete or its event_cycle changes, the outdated events are dropped by update_rob
+void O3_CPU::add_completion_event(uint32_t rob_index)
+{
+    if (ROB.entry[rob_index].executed != INFLIGHT)
+        return;
+    if (ROB.entry[rob_index].is_memory && ROB.entry[rob_index].num_mem_ops)
+        return;
+
+    completion_events.push(completion_event(ROB.entry[rob_index].event_cycle, ROB.entry[rob_index].instr_id, rob_index));
+}
+
 void O3_CPU::complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
 {
     uint32_t index = queue->head,
@@ -1999,6 +1998,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
         }
 
         ROB.entry[rob_index].event_cycle = queue->entry[index].event_cycle;
+        add_completion_event(rob_index);
     }
     else { // L1D
 
@@ -2022,6 +2022,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
 #endif
             if (ROB.entry[rob_index].num_mem_ops == 0)
                 inflight_mem_executions++;
+            add_completion_event(rob_index);
 
             DP (if (warmup_complete[cpu]) {
             cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[lq_index].instr_id;
@@ -2091,6 +2092,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
         }
 
         ROB.entry[rob_index].event_cycle = current_packet->event_cycle;
+        add_completion_event(rob_index);
     }
     else { // L1D
 
@@ -2127,6 +2129,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
             handle_merged_load(current_packet);
 
             ROB.entry[rob_index].event_cycle = current_packet->event_cycle;
+            add_completion_event(rob_index);
         }
     }
 }
@@ -2192,6 +2195,7 @@ void O3_CPU::handle_merged_load(PACKET *provider)
 
         if (ROB.entry[merged_rob_index].num_mem_ops == 0)
             inflight_mem_executions++;
+        add_completion_event(merged_rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[merged].instr_id;
@@ -2210,6 +2214,8 @@ void O3_CPU::release_load_queue(uint32_t lq_index)
     cout << "[LQ] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << " releases lq_index: " << lq_index;
     cout << hex << " full_addr: " << LQ.entry[lq_index].physical_address << dec << endl; });
 
+    LQ.slots->release(lq_index);
+
     LSQ_ENTRY empty_entry;
     LQ.entry[lq_index] = empty_entry;
     LQ.occupancy--;
@@ -2295,6 +2301,15 @@ void O3_CPU::retire_rob()
             }
         }
 
+        // the rename table forgets registers last written by this instruction
+        for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+            uint8_t reg = ROB.entry[ROB.head].destination_registers[i];
+            if (reg && (register_writer[reg] == ROB.head))
+                register_writer[reg] = UINT32_MAX;
+        }
+
+        remove_store_addresses(ROB.head);
+
         // release ROB entry
         DP ( if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[ROB.head].instr_id << " is retired" << endl; });
@@ -2310,3 +2325,34 @@ void O3_CPU::retire_rob()
         num_retired++;
     }
 }
+
+uint64_t O3_CPU::trace_record(uint64_t instr_id)
+{
+    // a rewound trace starts over from its first record
+    uint64_t record = trace_first_record + (instr_id - trace_first_instr_id);
+    for (uint32_t i=0; i<trace_rewinds.size(); i++) {
+        if (trace_rewinds[i] <= instr_id)
+            record = instr_id - trace_rewinds[i];
+    }
+
+    return record;
+}
+
+void O3_CPU::checkpoint(CHECKPOINT &checkpoint)
+{
+    ITLB.checkpoint(checkpoint);
+    DTLB.checkpoint(checkpoint);
+    STLB.checkpoint(checkpoint);
+    L1I.checkpoint(checkpoint);
+    L1D.checkpoint(checkpoint);
+    L2C.checkpoint(checkpoint);
+
+    if (checkpoint.begin_module(MODULE_BRANCH_PREDICTOR)) {
+        checkpoint_branch_predictor(checkpoint);
+        checkpoint.end_section();
+    }
+    if (checkpoint.begin_module(MODULE_L1I_PREFETCHER)) {
+        l1i_prefetcher_checkpoint(checkpoint);
+        checkpoint.end_section();
+    }
+}
@@ -0,0 +1,324 @@
+#include <chrono>
+#include "tracedecoder.h"
+
+TRACE_DECODER::TRACE_DECODER(TRACE_READER *v1, TRACE_READER *v2) : reader(v1), derived_reader(v2)
+{
+    ring = new TRACE_BATCH[TRACE_RING_SIZE];
+    ring_head = 0;
+    ring_tail = 0;
+    stop_requested = 0;
+    threaded = 0;
+
+    consumer_batch = NULL;
+    batch_pos = 0;
+
+    num_decoded = 0;
+    pending_rewind = 0;
+}
+
+TRACE_DECODER::~TRACE_DECODER()
+{
+    stop();
+    delete[] ring;
+    delete reader;
+    delete derived_reader;
+}
+
+void TRACE_DECODER::start()
+{
+    threaded = (std::thread::hardware_concurrency() > 1);
+    if (threaded)
+        producer = std::thread(&TRACE_DECODER::run, this);
+}
+
+void TRACE_DECODER::stop()
+{
+    stop_requested = 1;
+    if (producer.joinable())
+        producer.join();
+}
+
+void TRACE_DECODER::run()
+{
+    while (stop_requested == 0) {
+        // ring is full, the core is behind
+        if (!produce_batch())
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+uint8_t TRACE_DECODER::produce_batch()
+{
+    uint64_t tail = ring_tail.load(std::memory_order_relaxed);
+    if ((tail - ring_head.load(std::memory_order_acquire)) == TRACE_RING_SIZE)
+        return 0;
+
+    fill_batch(&ring[tail & (TRACE_RING_SIZE-1)]);
+    ring_tail.store(tail+1, std::memory_order_release);
+
+    return 1;
+}
+
+void TRACE_DECODER::fill_batch(TRACE_BATCH *batch)
+{
+    size_t instr_size = knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
+
+    batch->count = 0;
+    while (batch->count < TRACE_BATCH_SIZE) {
+        ooo_model_instr *arch_instr = &batch->entry[batch->count];
+
+        // records are decoded in place, straight out of the reader's buffer (or the mapped trace)
+        const void *record = reader->next_record(instr_size);
+        const derived_instr *derived = NULL;
+        if (derived_reader)
+            derived = (const derived_instr *)derived_reader->next_record(sizeof(derived_instr));
+
+        if (derived_reader && ((record == NULL) != (derived == NULL))) {
+            cerr << "[TRACE] " << __func__ << " derived cache does not match the trace: " << reader->trace_string << endl;
+            assert(0);
+        }
+
+        if (record == NULL) {
+            // reached end of file for this trace, the core reports it when it gets here
+            reader->rewind();
+            if (derived_reader)
+                derived_reader->rewind();
+            pending_rewind = 1;
+            continue;
+        }
+
+        *arch_instr = ooo_model_instr();
+        if (knob_cloudsuite)
+            decode_cloudsuite_instr((const cloudsuite_instr *)record, arch_instr);
+        else {
+            // the branch target comes from the following record, so decoding runs one record behind the trace
+            const input_instr *trace_read_instr = (const input_instr *)record;
+            if (num_decoded == 0) {
+                // the first record is paired with itself, which the derived cache does not hold
+                previous_instr = *trace_read_instr;
+                decode_input_instr(&previous_instr, trace_read_instr, arch_instr);
+            }
+            else if (derived_reader)
+                apply_derived_instr(&previous_instr, &previous_derived, arch_instr);
+            else
+                decode_input_instr(&previous_instr, trace_read_instr, arch_instr);
+
+            previous_instr = *trace_read_instr;
+            if (derived_reader)
+                previous_derived = *derived;
+        }
+
+        batch->rewound[batch->count] = pending_rewind;
+        pending_rewind = 0;
+        batch->count++;
+        num_decoded++;
+    }
+}
+
+void decode_cloudsuite_instr(const cloudsuite_instr *current, ooo_model_instr *arch_instr)
+{
+    // copy the instruction into the performance model's instruction format
+    int num_reg_ops = 0, num_mem_ops = 0;
+
+    arch_instr->ip = current->ip;
+    arch_instr->is_branch = current->is_branch;
+    arch_instr->branch_taken = current->branch_taken;
+
+    arch_instr->asid[0] = current->asid[0];
+    arch_instr->asid[1] = current->asid[1];
+
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        arch_instr->destination_registers[i] = current->destination_registers[i];
+        arch_instr->destination_memory[i] = current->destination_memory[i];
+        arch_instr->destination_virtual_address[i] = current->destination_memory[i];
+
+        if (arch_instr->destination_registers[i])
+            num_reg_ops++;
+        if (arch_instr->destination_memory[i])
+            num_mem_ops++;
+    }
+
+    for (int i=0; i<NUM_INSTR_SOURCES; i++) {
+        arch_instr->source_registers[i] = current->source_registers[i];
+        arch_instr->source_memory[i] = current->source_memory[i];
+        arch_instr->source_virtual_address[i] = current->source_memory[i];
+
+        if (arch_instr->source_registers[i])
+            num_reg_ops++;
+        if (arch_instr->source_memory[i])
+            num_mem_ops++;
+    }
+
+    arch_instr->num_reg_ops = num_reg_ops;
+    arch_instr->num_mem_ops = num_mem_ops;
+    if (num_mem_ops > 0)
+        arch_instr->is_memory = 1;
+}
+
+void decode_input_instr(const input_instr *current, const input_instr *next, ooo_model_instr *arch_instr)
+{
+    // copy the instruction into the performance model's instruction format
+    int num_reg_ops = 0, num_mem_ops = 0;
+
+    arch_instr->ip = current->ip;
+    arch_instr->is_branch = current->is_branch;
+    arch_instr->branch_taken = current->branch_taken;
+
+    bool reads_sp = false;
+    bool writes_sp = false;
+    bool reads_flags = false;
+    bool reads_ip = false;
+    bool writes_ip = false;
+    bool reads_other = false;
+
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        arch_instr->destination_registers[i] = current->destination_registers[i];
+        arch_instr->destination_memory[i] = current->destination_memory[i];
+        arch_instr->destination_virtual_address[i] = current->destination_memory[i];
+
+        switch(arch_instr->destination_registers[i])
+        {
+            case 0:
+                break;
+            case REG_STACK_POINTER:
+                writes_sp = true;
+                break;
+            case REG_INSTRUCTION_POINTER:
+                writes_ip = true;
+                break;
+            default:
+                break;
+        }
+
+        if (arch_instr->destination_registers[i])
+            num_reg_ops++;
+        if (arch_instr->destination_memory[i])
+            num_mem_ops++;
+    }
+
+    for (int i=0; i<NUM_INSTR_SOURCES; i++) {
+        arch_instr->source_registers[i] = current->source_registers[i];
+        arch_instr->source_memory[i] = current->source_memory[i];
+        arch_instr->source_virtual_address[i] = current->source_memory[i];
+
+        switch(arch_instr->source_registers[i])
+        {
+            case 0:
+                break;
+            case REG_STACK_POINTER:
+                reads_sp = true;
+                break;
+            case REG_FLAGS:
+                reads_flags = true;
+                break;
+            case REG_INSTRUCTION_POINTER:
+                reads_ip = true;
+                break;
+            default:
+                reads_other = true;
+                break;
+        }
+
+        if (arch_instr->source_registers[i])
+            num_reg_ops++;
+        if (arch_instr->source_memory[i])
+            num_mem_ops++;
+    }
+
+    arch_instr->num_reg_ops = num_reg_ops;
+    arch_instr->num_mem_ops = num_mem_ops;
+    if (num_mem_ops > 0)
+        arch_instr->is_memory = 1;
+
+    // determine what kind of branch this is, if any
+    if(!reads_sp && !reads_flags && writes_ip && !reads_other)
+    {
+        // direct jump
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = 1;
+        arch_instr->branch_type = BRANCH_DIRECT_JUMP;
+    }
+    else if(!reads_sp && !reads_flags && writes_ip && reads_other)
+    {
+        // indirect branch
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = 1;
+        arch_instr->branch_type = BRANCH_INDIRECT;
+    }
+    else if(!reads_sp && reads_ip && !writes_sp && writes_ip && reads_flags && !reads_other)
+    {
+        // conditional branch
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = arch_instr->branch_taken; // don't change this
+        arch_instr->branch_type = BRANCH_CONDITIONAL;
+    }
+    else if(reads_sp && reads_ip && writes_sp && writes_ip && !reads_flags && !reads_other)
+    {
+        // direct call
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = 1;
+        arch_instr->branch_type = BRANCH_DIRECT_CALL;
+    }
+    else if(reads_sp && reads_ip && writes_sp && writes_ip && !reads_flags && reads_other)
+    {
+        // indirect call
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = 1;
+        arch_instr->branch_type = BRANCH_INDIRECT_CALL;
+    }
+    else if(reads_sp && !reads_ip && writes_sp && writes_ip)
+    {
+        // return
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = 1;
+        arch_instr->branch_type = BRANCH_RETURN;
+    }
+    else if(writes_ip)
+    {
+        // some other branch type that doesn't fit the above categories
+        arch_instr->is_branch = 1;
+        arch_instr->branch_taken = arch_instr->branch_taken; // don't change this
+        arch_instr->branch_type = BRANCH_OTHER;
+    }
+
+    if((arch_instr->is_branch == 1) && (arch_instr->branch_taken == 1))
+    {
+        arch_instr->branch_target = next->ip;
+    }
+}
+
+void apply_derived_instr(const input_instr *current, const derived_instr *derived, ooo_model_instr *arch_instr)
+{
+    arch_instr->ip = current->ip;
+
+    for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS; i++) {
+        arch_instr->destination_registers[i] = current->destination_registers[i];
+        arch_instr->destination_memory[i] = current->destination_memory[i];
+        arch_instr->destination_virtual_address[i] = current->destination_memory[i];
+    }
+
+    for (int i=0; i<NUM_INSTR_SOURCES; i++) {
+        arch_instr->source_registers[i] = current->source_registers[i];
+        arch_instr->source_memory[i] = current->source_memory[i];
+        arch_instr->source_virtual_address[i] = current->source_memory[i];
+    }
+
+    arch_instr->is_branch = derived->is_branch;
+    arch_instr->branch_taken = derived->branch_taken;
+    arch_instr->branch_type = derived->branch_type;
+    arch_instr->branch_target = derived->branch_target;
+    arch_instr->num_reg_ops = derived->num_reg_ops;
+    arch_instr->num_mem_ops = derived->num_mem_ops;
+    arch_instr->is_memory = derived->is_memory;
+}
+
+void derive_instr(const ooo_model_instr *arch_instr, derived_instr *derived)
+{
+    derived->branch_target = arch_instr->branch_target;
+    derived->is_branch = arch_instr->is_branch;
+    derived->branch_taken = arch_instr->branch_taken;
+    derived->branch_type = arch_instr->branch_type;
+    derived->num_reg_ops = arch_instr->num_reg_ops;
+    derived->num_mem_ops = arch_instr->num_mem_ops;
+    derived->is_memory = arch_instr->is_memory;
+}
@@ -0,0 +1,697 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include "tracereader.h"
+
+TRACE_READER::TRACE_READER(string v1, uint8_t v2) : trace_string(v1)
+{
+    format_record_size = 0;
+    input_pos = 0;
+    input_begin = 0;
+    input_end = UINT64_MAX;
+    input_done = 0;
+
+    in_buffer = NULL;
+    out_buffer = NULL;
+    out_head = 0;
+    out_tail = 0;
+
+    file = NULL;
+    is_pipe = (trace_string.substr(0, 4) == "http");
+    if (v2) {
+        in_buffer = new uint8_t[TRACE_INPUT_BUFFER_SIZE];
+        out_buffer = new uint8_t[TRACE_OUTPUT_BUFFER_SIZE];
+        open_file();
+    }
+}
+
+TRACE_READER::~TRACE_READER()
+{
+    if (file && is_pipe)
+        pclose(file);
+    else if (file)
+        fclose(file);
+
+    delete[] in_buffer;
+    delete[] out_buffer;
+}
+
+void TRACE_READER::open_file()
+{
+    if (is_pipe) {
+        // remote traces are still fetched by wget, but decompressed here
+        string command = "wget -qO- " + trace_string;
+        file = popen(command.c_str(), "r");
+    }
+    else
+        file = fopen(trace_string.c_str(), "rb");
+
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_string << " ***" << endl;
+        assert(0);
+    }
+
+    input_done = 0;
+}
+
+uint64_t TRACE_READER::read_input()
+{
+    if (input_done)
+        return 0;
+
+    uint64_t bytes = TRACE_INPUT_BUFFER_SIZE;
+    if ((input_end - input_pos) < bytes)
+        bytes = input_end - input_pos;
+
+    bytes = fread(in_buffer, 1, bytes, file);
+    if (bytes == 0)
+        input_done = 1;
+    input_pos += bytes;
+
+    return bytes;
+}
+
+void TRACE_READER::restart_input(uint64_t offset)
+{
+    clearerr(file);
+    fseek(file, offset, SEEK_SET);
+    input_pos = offset;
+    input_done = 0;
+
+    out_head = 0;
+    out_tail = 0;
+    reset_decoder();
+}
+
+uint64_t TRACE_READER::discard_records(uint64_t num_records, uint32_t record_size)
+{
+    uint64_t discarded = 0;
+    while (discarded < num_records) {
+        uint64_t available = (out_tail - out_head) / record_size;
+        if (available == 0) {
+            if (refill() < record_size)
+                break;
+            continue;
+        }
+
+        if (available > (num_records - discarded))
+            available = num_records - discarded;
+        out_head += available * record_size;
+        discarded += available;
+    }
+
+    return discarded;
+}
+
+uint8_t TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    // no index, decode everything up to the record
+    rewind();
+    return (discard_records(record, record_size) == record);
+}
+
+uint64_t TRACE_READER::refill()
+{
+    // keep the partial record at the end of the buffer
+    uint64_t remain = out_tail - out_head;
+    if (remain)
+        memmove(out_buffer, out_buffer + out_head, remain);
+    out_head = 0;
+    out_tail = remain;
+
+    out_tail += decode(out_buffer + out_tail, TRACE_OUTPUT_BUFFER_SIZE - out_tail);
+
+    return out_tail - out_head;
+}
+
+void TRACE_READER::rewind()
+{
+    if (is_pipe) {
+        pclose(file);
+        open_file();
+
+        out_head = 0;
+        out_tail = 0;
+        reset_decoder();
+    }
+    else
+        restart_input(input_begin);
+}
+
+GZIP_TRACE_READER::GZIP_TRACE_READER(string v1) : TRACE_READER(v1)
+{
+    memset(&strm, 0, sizeof(strm));
+
+    // 15+32: accept both gzip and zlib headers
+    if (inflateInit2(&strm, 15+32) != Z_OK) {
+        cerr << "[TRACE] " << __func__ << " cannot initialize gzip decoder for " << trace_string << endl;
+        assert(0);
+    }
+}
+
+GZIP_TRACE_READER::~GZIP_TRACE_READER()
+{
+    inflateEnd(&strm);
+}
+
+uint64_t GZIP_TRACE_READER::decode(uint8_t *dest, uint64_t size)
+{
+    strm.next_out = dest;
+    strm.avail_out = size;
+
+    while (strm.avail_out) {
+        if (strm.avail_in == 0) {
+            strm.next_in = in_buffer;
+            strm.avail_in = read_input();
+            if (strm.avail_in == 0)
+                break;
+        }
+
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            // concatenated gzip members are decoded back to back, like gzip -dc does
+            inflateReset(&strm);
+        }
+        else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+            cerr << "[TRACE] " << __func__ << " gzip decode error: " << ret << " trace: " << trace_string << endl;
+            assert(0);
+        }
+    }
+
+    return size - strm.avail_out;
+}
+
+void GZIP_TRACE_READER::reset_decoder()
+{
+    strm.avail_in = 0;
+    inflateReset(&strm);
+}
+
+XZ_TRACE_READER::XZ_TRACE_READER(string v1) : TRACE_READER(v1)
+{
+    strm = LZMA_STREAM_INIT;
+    reset_decoder();
+}
+
+XZ_TRACE_READER::~XZ_TRACE_READER()
+{
+    lzma_end(&strm);
+}
+
+uint64_t XZ_TRACE_READER::decode(uint8_t *dest, uint64_t size)
+{
+    strm.next_out = dest;
+    strm.avail_out = size;
+
+    while (strm.avail_out) {
+        if ((strm.avail_in == 0) && (input_done == 0)) {
+            strm.next_in = in_buffer;
+            strm.avail_in = read_input();
+        }
+
+        lzma_ret ret = lzma_code(&strm, input_done ? LZMA_FINISH : LZMA_RUN);
+        if (ret == LZMA_STREAM_END)
+            break;
+        if (ret != LZMA_OK) {
+            cerr << "[TRACE] " << __func__ << " xz decode error: " << ret << " trace: " << trace_string << endl;
+            assert(0);
+        }
+    }
+
+    return size - strm.avail_out;
+}
+
+void XZ_TRACE_READER::reset_decoder()
+{
+    lzma_end(&strm);
+    strm = LZMA_STREAM_INIT;
+
+    // LZMA_CONCATENATED: decode multi-stream files the same way xz -dc does
+    if (lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+        cerr << "[TRACE] " << __func__ << " cannot initialize xz decoder for " << trace_string << endl;
+        assert(0);
+    }
+}
+
+CHUNKED_TRACE_READER::CHUNKED_TRACE_READER(string v1) : XZ_TRACE_READER(v1)
+{
+    if (is_pipe) {
+        cerr << "[TRACE] " << __func__ << " chunked traces must be local files: " << trace_string << endl;
+        assert(0);
+    }
+
+    if (!read_chunked_trace_index(file, CHUNKED_TRACE_MAGIC, &header, &index)) {
+        cerr << "[TRACE] " << __func__ << " not a chunked trace: " << trace_string << endl;
+        assert(0);
+    }
+
+    format_record_size = header.record_size;
+    input_begin = sizeof(header);
+    input_end = header.index_offset;
+    restart_input(input_begin);
+}
+
+uint8_t CHUNKED_TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    if (record >= header.num_records)
+        return 0;
+
+    // jump straight to the chunk holding the record and decode only the part of it in front of the record
+    uint64_t chunk = find_chunk(index, record);
+    restart_input(index[chunk].offset);
+
+    return (discard_records(record - index[chunk].first_record, record_size) == (record - index[chunk].first_record));
+}
+
+COLUMNAR_TRACE_READER::COLUMNAR_TRACE_READER(string v1) : TRACE_READER(v1)
+{
+    if (is_pipe) {
+        cerr << "[TRACE] " << __func__ << " chunked traces must be local files: " << trace_string << endl;
+        assert(0);
+    }
+
+    if (!read_chunked_trace_index(file, CHUNKED_TRACE_COLUMNAR_MAGIC, &header, &index)) {
+        cerr << "[TRACE] " << __func__ << " not a columnar chunked trace: " << trace_string << endl;
+        assert(0);
+    }
+
+    if (header.record_size != sizeof(input_instr)) {
+        cerr << "[TRACE] " << __func__ << " columnar traces only hold input_instr records: " << trace_string << endl;
+        assert(0);
+    }
+
+    compressed_size = 0;
+    for (uint64_t i=0; i<index.size(); i++)
+        if (index[i].size > compressed_size)
+            compressed_size = index[i].size;
+    encoded_size = COLUMNAR_TRACE_CODEC::encoded_bound(header.records_per_chunk);
+
+    codec = new COLUMNAR_TRACE_CODEC(header.records_per_chunk);
+    records = new input_instr[header.records_per_chunk];
+    compressed = new uint8_t[compressed_size];
+    encoded = new uint8_t[encoded_size];
+
+    // records are handed out straight from the decoded chunk
+    delete[] out_buffer;
+    out_buffer = (uint8_t *)records;
+
+    format_record_size = header.record_size;
+    input_begin = sizeof(header);
+    input_end = header.index_offset;
+    restart_input(input_begin);
+}
+
+COLUMNAR_TRACE_READER::~COLUMNAR_TRACE_READER()
+{
+    delete codec;
+    delete[] records;
+    delete[] compressed;
+    delete[] encoded;
+    out_buffer = NULL;
+}
+
+uint64_t COLUMNAR_TRACE_READER::refill()
+{
+    // chunks hold whole records, so the current chunk is only replaced once it is used up
+    if ((out_tail > out_head) || (next_chunk >= index.size()))
+        return out_tail - out_head;
+
+    chunked_trace_index_entry *chunk = &index[next_chunk++];
+    fseek(file, chunk->offset, SEEK_SET);
+    if (fread(compressed, 1, chunk->size, file) != chunk->size) {
+        cerr << "[TRACE] " << __func__ << " truncated chunk " << (next_chunk-1) << " trace: " << trace_string << endl;
+        assert(0);
+    }
+
+    uint64_t memlimit = UINT64_MAX;
+    size_t in_pos = 0, out_pos = 0;
+    lzma_ret ret = lzma_stream_buffer_decode(&memlimit, 0, NULL, compressed, &in_pos, chunk->size, encoded, &out_pos, encoded_size);
+    uint32_t num_records = (ret == LZMA_OK) ? codec->decode(encoded, out_pos, records) : 0;
+    if (num_records == 0) {
+        cerr << "[TRACE] " << __func__ << " corrupted chunk " << (next_chunk-1) << " trace: " << trace_string << endl;
+        assert(0);
+    }
+
+    out_head = 0;
+    out_tail = (uint64_t)num_records * sizeof(input_instr);
+
+    return out_tail;
+}
+
+uint8_t COLUMNAR_TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    if (record >= header.num_records)
+        return 0;
+
+    uint64_t chunk = find_chunk(index, record);
+    out_head = 0;
+    out_tail = 0;
+    next_chunk = chunk;
+
+    return (discard_records(record - index[chunk].first_record, record_size) == (record - index[chunk].first_record));
+}
+
+MMAP_TRACE_READER::MMAP_TRACE_READER(string v1) : TRACE_READER(v1)
+{
+    if (is_pipe) {
+        cerr << "[TRACE] " << __func__ << " uncompressed traces must be local files: " << trace_string << endl;
+        assert(0);
+    }
+
+    struct stat file_stat;
+    if (fstat(fileno(file), &file_stat) != 0) {
+        cerr << "[TRACE] " << __func__ << " cannot stat " << trace_string << endl;
+        assert(0);
+    }
+
+    mapping = NULL;
+    mapping_size = file_stat.st_size;
+    if (mapping_size) {
+        mapping = (uint8_t *)mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (mapping == MAP_FAILED) {
+            cerr << "[TRACE] " << __func__ << " cannot map " << trace_string << endl;
+            assert(0);
+        }
+        madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+    }
+
+    // records are read in place, the decompression buffer is not needed
+    delete[] out_buffer;
+    out_buffer = mapping;
+}
+
+MMAP_TRACE_READER::~MMAP_TRACE_READER()
+{
+    if (mapping)
+        munmap(mapping, mapping_size);
+    out_buffer = NULL;
+}
+
+uint64_t MMAP_TRACE_READER::refill()
+{
+    // expose the next window of the mapping and ask the kernel to read ahead of it
+    uint64_t window_begin = out_tail,
+             window_end = out_tail + TRACE_MMAP_WINDOW;
+    if (window_end > mapping_size)
+        window_end = mapping_size;
+
+    if (window_begin < window_end) {
+        uint64_t advice_begin = window_begin & ~(uint64_t)(sysconf(_SC_PAGESIZE)-1),
+                 advice_end = window_end + TRACE_MMAP_WINDOW;
+        if (advice_end > mapping_size)
+            advice_end = mapping_size;
+        madvise(mapping + advice_begin, advice_end - advice_begin, MADV_WILLNEED);
+    }
+
+    out_tail = window_end;
+
+    return out_tail - out_head;
+}
+
+uint8_t MMAP_TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    uint64_t offset = record * record_size;
+    if (offset >= mapping_size)
+        return 0;
+
+    out_head = offset;
+    out_tail = offset;
+
+    return 1;
+}
+
+shared_ptr <TRACE_CHUNK> TRACE_CHUNK::read(TRACE_READER *reader, uint32_t record_size, uint64_t first_record)
+{
+    shared_ptr <TRACE_CHUNK> chunk = make_shared<TRACE_CHUNK>();
+
+    uint64_t capacity = TRACE_OUTPUT_BUFFER_SIZE / record_size;
+    chunk->data.resize(capacity * record_size);
+
+    uint64_t num_records = 0;
+    const void *record;
+    while ((num_records < capacity) && ((record = reader->next_record(record_size)) != NULL))
+        memcpy(&chunk->data[(num_records++) * record_size], record, record_size);
+    chunk->data.resize(num_records * record_size);
+
+    chunk->end_of_trace = (num_records == 0);
+    chunk->next_record = first_record + num_records;
+    if (chunk->end_of_trace) {
+        reader->rewind();
+        chunk->next_record = 0;
+    }
+
+    return chunk;
+}
+
+SHARED_TRACE_SOURCE::SHARED_TRACE_SOURCE(TRACE_READER *v1, uint32_t v2, uint32_t v3, uint64_t v4) : reader(v1), record_size(v2), num_readers(v3), first_record(v4)
+{
+    first_chunk = 0;
+    last_record = first_record;
+}
+
+SHARED_TRACE_SOURCE::~SHARED_TRACE_SOURCE()
+{
+    delete reader;
+}
+
+shared_ptr <TRACE_CHUNK> SHARED_TRACE_SOURCE::get_chunk(uint64_t seq)
+{
+    std::lock_guard<std::mutex> guard(chunk_lock);
+
+    // dropped while the reader lagged behind
+    if (seq < first_chunk)
+        return NULL;
+
+    while ((first_chunk + chunks.size()) <= seq) {
+        uint64_t position = chunks.size() ? chunks.back()->next_record : last_record;
+        chunks.push_back(TRACE_CHUNK::read(reader, record_size, position));
+        chunks.back()->readers_left = num_readers;
+
+        // bound the cache, the readers that did not get to the oldest chunk will detach
+        if (chunks.size() > SHARED_TRACE_MAX_CHUNKS) {
+            last_record = chunks.front()->next_record;
+            chunks.pop_front();
+            first_chunk++;
+        }
+    }
+
+    shared_ptr <TRACE_CHUNK> chunk = chunks[seq - first_chunk];
+    chunk->readers_left--;
+    drop_used_chunks();
+
+    return chunk;
+}
+
+void SHARED_TRACE_SOURCE::detach()
+{
+    std::lock_guard<std::mutex> guard(chunk_lock);
+
+    // the reader is behind every cached chunk
+    num_readers--;
+    for (uint32_t i=0; i<chunks.size(); i++)
+        chunks[i]->readers_left--;
+    drop_used_chunks();
+}
+
+void SHARED_TRACE_SOURCE::drop_used_chunks()
+{
+    // every reader is past the oldest chunks, drop them from the cache
+    while (chunks.size() && (chunks.front()->readers_left == 0)) {
+        last_record = chunks.front()->next_record;
+        chunks.pop_front();
+        first_chunk++;
+    }
+}
+
+SHARED_TRACE_READER::SHARED_TRACE_READER(shared_ptr <SHARED_TRACE_SOURCE> v1) : TRACE_READER(v1->reader->trace_string, 0), source(v1)
+{
+    format_record_size = source->reader->format_record_size;
+    private_reader = NULL;
+    next_chunk = 0;
+    next_record = source->first_record;
+    at_end = 0;
+}
+
+SHARED_TRACE_READER::~SHARED_TRACE_READER()
+{
+    // the buffer belongs to the chunk
+    out_buffer = NULL;
+    delete private_reader;
+}
+
+uint64_t SHARED_TRACE_READER::refill()
+{
+    // chunks hold whole records, so the current chunk is only replaced once it is used up
+    if ((out_tail > out_head) || at_end)
+        return out_tail - out_head;
+
+    shared_ptr <TRACE_CHUNK> chunk;
+    if (private_reader == NULL) {
+        chunk = source->get_chunk(next_chunk++);
+        if (chunk == NULL) {
+            // too far behind the other readers, go on from the same record with a reader of our own
+            source->detach();
+            private_reader = open_trace_reader(trace_string.c_str());
+            if ((private_reader == NULL) || (next_record && !private_reader->seek(next_record, source->record_size))) {
+                cerr << "[TRACE] " << __func__ << " cannot reopen the shared trace: " << trace_string << " at record: " << next_record << endl;
+                assert(0);
+            }
+        }
+    }
+    if (private_reader)
+        chunk = TRACE_CHUNK::read(private_reader, source->record_size, next_record);
+
+    current_chunk = chunk;
+    next_record = current_chunk->next_record;
+    out_head = 0;
+    out_tail = current_chunk->data.size();
+    out_buffer = out_tail ? &current_chunk->data[0] : NULL;
+
+    at_end = current_chunk->end_of_trace;
+
+    return out_tail;
+}
+
+void SHARED_TRACE_READER::rewind()
+{
+    // the source has already gone back to the top of the trace, the chunk after the end marker holds the first records
+    at_end = 0;
+}
+
+uint8_t SHARED_TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    // shared traces are positioned through the source reader before any chunk is handed out
+    cerr << "[TRACE] " << __func__ << " cannot seek a shared trace: " << trace_string << endl;
+    return 0;
+}
+
+SWEEP_TRACE_RING *SWEEP_TRACE_RING::create(uint32_t record_size, uint32_t num_readers)
+{
+    uint64_t size = sizeof(SWEEP_TRACE_RING) + SWEEP_RING_SLOTS * (uint64_t)TRACE_OUTPUT_BUFFER_SIZE;
+    void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        cerr << "[TRACE] " << __func__ << " cannot map a sweep ring of " << size << " bytes" << endl;
+        assert(0);
+    }
+
+    SWEEP_TRACE_RING *ring = new (mapping) SWEEP_TRACE_RING;
+    ring->record_size = record_size;
+    ring->num_readers = num_readers;
+    ring->produced = 0;
+    for (uint32_t i=0; i<SWEEP_MAX_CONFIGS; i++)
+        ring->consumed[i] = (i < num_readers) ? 0 : UINT64_MAX;
+    ring->stop_requested = 0;
+    ring->data = (uint8_t *)mapping + sizeof(SWEEP_TRACE_RING);
+
+    return ring;
+}
+
+void SWEEP_TRACE_RING::produce(TRACE_READER *reader)
+{
+    uint64_t capacity = TRACE_OUTPUT_BUFFER_SIZE / record_size;
+
+    for (uint64_t seq=0; ; seq++) {
+        // the slot is free once every configuration is past the chunk it held
+        while (1) {
+            if (stop_requested.load())
+                return;
+
+            // UINT64_MAX once every configuration has exited, the parent then stops the ring
+            uint64_t oldest = UINT64_MAX;
+            for (uint32_t i=0; i<num_readers; i++)
+                if (consumed[i].load(std::memory_order_acquire) < oldest)
+                    oldest = consumed[i].load(std::memory_order_acquire);
+            if ((oldest != UINT64_MAX) && (seq < oldest + SWEEP_RING_SLOTS))
+                break;
+            std::this_thread::yield();
+        }
+
+        uint8_t *dest = slot_data(seq);
+        uint64_t num_records = 0;
+        const void *record;
+        while ((num_records < capacity) && ((record = reader->next_record(record_size)) != NULL))
+            memcpy(dest + (num_records++) * record_size, record, record_size);
+
+        slots[seq & (SWEEP_RING_SLOTS-1)].size = num_records * record_size;
+        slots[seq & (SWEEP_RING_SLOTS-1)].end_of_trace = (num_records == 0);
+        if (num_records == 0)
+            reader->rewind();
+
+        produced.store(seq + 1, std::memory_order_release);
+    }
+}
+
+SWEEP_TRACE_READER::SWEEP_TRACE_READER(SWEEP_TRACE_RING *v1, uint32_t v2, string v3) : TRACE_READER(v3, 0), ring(v1), config(v2)
+{
+    next_chunk = 0;
+    at_end = 0;
+}
+
+SWEEP_TRACE_READER::~SWEEP_TRACE_READER()
+{
+    // the buffer belongs to the ring
+    out_buffer = NULL;
+}
+
+uint64_t SWEEP_TRACE_READER::refill()
+{
+    // chunks hold whole records, so the current chunk is only given back once it is used up
+    if ((out_tail > out_head) || at_end)
+        return out_tail - out_head;
+
+    ring->consumed[config].store(next_chunk, std::memory_order_release);
+    while (ring->produced.load(std::memory_order_acquire) <= next_chunk)
+        std::this_thread::yield();
+
+    out_head = 0;
+    out_tail = ring->slot_size(next_chunk);
+    out_buffer = ring->slot_data(next_chunk);
+    at_end = ring->slot_end_of_trace(next_chunk);
+    next_chunk++;
+
+    return out_tail;
+}
+
+void SWEEP_TRACE_READER::rewind()
+{
+    // the parent has already gone back to the top of the trace, the chunk after the end marker holds the first records
+    at_end = 0;
+}
+
+uint8_t SWEEP_TRACE_READER::seek(uint64_t record, uint32_t record_size)
+{
+    // the parent positions the trace before any chunk is handed out
+    cerr << "[TRACE] " << __func__ << " cannot seek a sweep trace: " << trace_string << endl;
+    return 0;
+}
+
+TRACE_READER *open_trace_reader(const char *trace_string)
+{
+    string full_name(trace_string);
+    size_t last_dot = full_name.find_last_of(".");
+    if ((last_dot == string::npos) || (last_dot+1 >= full_name.size()))
+        return NULL;
+
+    string extension = full_name.substr(last_dot+1);
+    if (extension == "cct") { // chunked container, the magic tells how the chunks are encoded
+        char magic[sizeof(chunked_trace_header::magic)] = {0};
+        FILE *file = fopen(full_name.c_str(), "rb");
+        if (file) {
+            if (fread(magic, sizeof(magic), 1, file) != 1)
+                magic[0] = 0;
+            fclose(file);
+        }
+
+        if (memcmp(magic, CHUNKED_TRACE_COLUMNAR_MAGIC, sizeof(magic)) == 0)
+            return new COLUMNAR_TRACE_READER(full_name);
+        return new CHUNKED_TRACE_READER(full_name);
+    }
+    else if (extension == "raw") // uncompressed, memory-mapped
+        return new MMAP_TRACE_READER(full_name);
+    else if (full_name[last_dot+1] == 'g') // gzip format
+        return new GZIP_TRACE_READER(full_name);
+    else if (full_name[last_dot+1] == 'x') // xz
+        return new XZ_TRACE_READER(full_name);
+
+    return NULL;
+}
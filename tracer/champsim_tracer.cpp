@@ -11,9 +11,18 @@
 #include <string.h>
 #include <string>
 
+// build with TRACER_COMPRESSION=1 (see makefile.rules) to write .xz and seekable chunked .cct traces directly,
+// this needs liblzma to be linkable into the pin tool
+#ifdef TRACER_COMPRESSION
+#include <lzma.h>
+#include "../inc/chunked_trace.h"
+#endif
+
 #define NUM_INSTR_DESTINATIONS 2
 #define NUM_INSTR_SOURCES 4
 
+#define OUTPUT_BUFFER_SIZE (1<<26) // records are collected in memory and written out 64MB at a time
+
 using namespace std;
 
 typedef struct trace_instr_format {
@@ -37,6 +46,19 @@ UINT64 instrCount = 0;
 
 FILE* out;
 
+// how the trace is written, picked from the output file extension
+enum output_format_t { OUTPUT_RAW, OUTPUT_XZ, OUTPUT_CHUNKED };
+output_format_t output_format = OUTPUT_RAW;
+
+unsigned char *output_buffer;
+size_t output_fill = 0;
+
+#ifdef TRACER_COMPRESSION
+lzma_stream xz_stream = LZMA_STREAM_INIT;
+unsigned char *xz_buffer;
+CHUNKED_TRACE_WRITER *chunked_writer;
+#endif
+
 bool output_file_closed = false;
 bool tracing_on = false;
 
@@ -54,6 +76,12 @@ KNOB<UINT64> KnobSkipInstructions(KNOB_MODE_WRITEONCE, "pintool", "s", "0",
 KNOB<UINT64> KnobTraceInstructions(KNOB_MODE_WRITEONCE, "pintool", "t", "1000000", 
         "How many instructions to trace");
 
+KNOB<UINT32> KnobCompressionPreset(KNOB_MODE_WRITEONCE, "pintool", "z", "1", 
+        "xz preset (0-9) for .xz and .cct output, low presets keep up with tracing");
+
+KNOB<UINT32> KnobChunkRecords(KNOB_MODE_WRITEONCE, "pintool", "chunk", "1048576", 
+        "Instructions per chunk of .cct output");
+
 /* ===================================================================== */
 // Utilities
 /* ===================================================================== */
@@ -66,13 +94,126 @@ INT32 Usage()
     cerr << "This tool creates a register and memory access trace" << endl 
         << "Specify the output trace file with -o" << endl 
         << "Specify the number of instructions to skip before tracing with -s" << endl
-        << "Specify the number of instructions to trace with -t" << endl << endl;
+        << "Specify the number of instructions to trace with -t" << endl
+        << "Output files ending in .xz or .cct are compressed in-process (tool built with TRACER_COMPRESSION=1)" << endl << endl;
 
     cerr << KNOB_BASE::StringKnobSummary() << endl;
 
     return -1;
 }
 
+/* ===================================================================== */
+// Trace output
+/* ===================================================================== */
+
+void OpenOutput(const char* fileName)
+{
+    string name(fileName);
+    size_t dot = name.find_last_of(".");
+    string extension = (dot == string::npos) ? "" : name.substr(dot+1);
+
+    if(extension == "xz")
+        output_format = OUTPUT_XZ;
+    else if(extension == "cct")
+        output_format = OUTPUT_CHUNKED;
+
+#ifndef TRACER_COMPRESSION
+    if(output_format != OUTPUT_RAW)
+    {
+        cout << "Compressed output needs the tool to be built with TRACER_COMPRESSION=1. Exiting." << endl;
+        exit(1);
+    }
+#endif
+
+    // the chunked container rewrites its header when it is closed, so it cannot be appended to
+    out = fopen(fileName, (output_format == OUTPUT_CHUNKED) ? "wb" : "ab");
+    if (!out) 
+    {
+        cout << "Couldn't open output trace file. Exiting." << endl;
+        exit(1);
+    }
+
+    output_buffer = new unsigned char[OUTPUT_BUFFER_SIZE];
+
+#ifdef TRACER_COMPRESSION
+    if(output_format == OUTPUT_XZ)
+    {
+        xz_buffer = new unsigned char[OUTPUT_BUFFER_SIZE];
+        if(lzma_easy_encoder(&xz_stream, KnobCompressionPreset.Value(), LZMA_CHECK_CRC64) != LZMA_OK)
+        {
+            cout << "Couldn't initialize the xz encoder. Exiting." << endl;
+            exit(1);
+        }
+    }
+    else if(output_format == OUTPUT_CHUNKED)
+        chunked_writer = new CHUNKED_TRACE_WRITER(out, sizeof(trace_instr_format_t), KnobChunkRecords.Value(), KnobCompressionPreset.Value());
+#endif
+}
+
+#ifdef TRACER_COMPRESSION
+void CompressOutput(size_t size, lzma_action action)
+{
+    xz_stream.next_in = output_buffer;
+    xz_stream.avail_in = size;
+
+    lzma_ret ret;
+    do
+    {
+        xz_stream.next_out = xz_buffer;
+        xz_stream.avail_out = OUTPUT_BUFFER_SIZE;
+        ret = lzma_code(&xz_stream, action);
+        fwrite(xz_buffer, 1, OUTPUT_BUFFER_SIZE - xz_stream.avail_out, out);
+    } while((xz_stream.avail_in > 0) || ((action == LZMA_FINISH) && (ret == LZMA_OK)));
+}
+#endif
+
+void FlushOutput()
+{
+    if(output_format == OUTPUT_RAW)
+        fwrite(output_buffer, 1, output_fill, out);
+#ifdef TRACER_COMPRESSION
+    else if(output_format == OUTPUT_XZ)
+        CompressOutput(output_fill, LZMA_RUN);
+    else
+    {
+        for(size_t i=0; i<output_fill; i+=sizeof(trace_instr_format_t))
+            chunked_writer->write_record(output_buffer + i);
+    }
+#endif
+
+    output_fill = 0;
+}
+
+void WriteInstruction(const trace_instr_format_t *instr)
+{
+    memcpy(output_buffer + output_fill, instr, sizeof(trace_instr_format_t));
+    output_fill += sizeof(trace_instr_format_t);
+
+    if((output_fill + sizeof(trace_instr_format_t)) > OUTPUT_BUFFER_SIZE)
+        FlushOutput();
+}
+
+void CloseOutput()
+{
+    if(output_file_closed)
+        return;
+
+    FlushOutput();
+
+#ifdef TRACER_COMPRESSION
+    if(output_format == OUTPUT_XZ)
+    {
+        CompressOutput(0, LZMA_FINISH);
+        lzma_end(&xz_stream);
+    }
+    else if(output_format == OUTPUT_CHUNKED)
+        chunked_writer->finish();
+#endif
+
+    fclose(out);
+    output_file_closed = true;
+}
+
 /* ===================================================================== */
 // Analysis routines
 /* ===================================================================== */
@@ -125,17 +266,13 @@ void EndInstruction()
         if(instrCount <= (KnobTraceInstructions.Value()+KnobSkipInstructions.Value()))
         {
             // keep tracing
-            fwrite(&curr_instr, sizeof(trace_instr_format_t), 1, out);
+            WriteInstruction(&curr_instr);
         }
         else
         {
             tracing_on = false;
             // close down the file, we're done tracing
-            if(!output_file_closed)
-            {
-                fclose(out);
-                output_file_closed = true;
-            }
+            CloseOutput();
 
             exit(0);
         }
@@ -379,11 +516,7 @@ VOID Instruction(INS ins, VOID *v)
 VOID Fini(INT32 code, VOID *v)
 {
     // close the file if it hasn't already been closed
-    if(!output_file_closed) 
-    {
-        fclose(out);
-        output_file_closed = true;
-    }
+    CloseOutput();
 }
 
 /*!
@@ -401,13 +534,7 @@ int main(int argc, char *argv[])
         return Usage();
 
     const char* fileName = KnobOutputFile.Value().c_str();
-
-    out = fopen(fileName, "ab");
-    if (!out) 
-    {
-        cout << "Couldn't open output trace file. Exiting." << endl;
-        exit(1);
-    }
+    OpenOutput(fileName);
 
     // Register function to be called to instrument instructions
     INS_AddInstrumentFunction(Instruction, 0);